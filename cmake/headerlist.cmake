@@ -1,5 +1,5 @@
 set(headers ${headers}
-	src/Hooks.h
+	include/AlchemyEffectRandomizerAPI.h
 	src/Manager.h
 	src/PCH.h
 )
@@ -1,5 +1,4 @@
 set(sources ${sources}
-	src/Hooks.cpp
 	src/main.cpp
 	src/Manager.cpp
 	src/PCH.cpp
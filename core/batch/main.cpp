@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <ostream>
+#include <print>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "Randomizer/IngredientDump.h"
+#include "Randomizer/Serialize.h"
+#include "Randomizer/Shuffle.h"
+#include "Randomizer/ThreadPool.h"
+
+// Shuffles an ingredient dump exported by the plugin (bExportIngredients) with many seeds, to compare them without launching the game.
+// Each seed runs on one core with the in-game shuffle code, so results match iSeed in Game Load mode and never depend on the thread count.
+
+namespace
+{
+	struct Settings
+	{
+		std::filesystem::path          dumpPath;
+		std::filesystem::path          outDirectory{ "." };
+		std::uint64_t                  firstSeed{ 1 };
+		std::uint64_t                  seedCount{ 1000 };
+		Randomizer::SHUFFLE_METHOD     method{ Randomizer::SHUFFLE_METHOD::kShuffle };
+		Randomizer::ShuffleConstraints constraints;
+		std::size_t                    threadCount{ std::max(1u, std::thread::hardware_concurrency()) - 1 };
+		std::size_t                    top{ 10 };
+	};
+
+	// seeds per pass, bounds how many results are held before they are written out
+	constexpr std::size_t seedsPerBatch = 1024;
+
+	// results.bin : magic + version, dump hash, method, group count, seed count, [u64 seed, u8 status, 4 x u16 effect index per group] per seed
+	constexpr std::uint32_t resultsMagic = 'A' | 'E' << 8 | 'R' << 16 | 'R' << 24;
+	constexpr std::uint32_t resultsVersion = 1;
+
+	struct Metrics
+	{
+		std::uint64_t                     seed{ 0 };
+		Randomizer::ShuffleResult::STATUS status{ Randomizer::ShuffleResult::STATUS::kSuccess };
+		std::uint32_t                     repairs{ 0 };
+		bool                              constructed{ false };
+		std::uint32_t                     rebalanced{ 0 };
+		std::size_t                       effects{ 0 };         // base effects in play
+		std::size_t                       minPerEffect{ 0 };    // ingredients sharing the rarest base effect
+		std::size_t                       maxPerEffect{ 0 };    // ingredients sharing the most common base effect
+		std::size_t                       singleEffects{ 0 };   // base effects on a single ingredient, can't be crafted
+		std::uint64_t                     craftablePairs{ 0 };  // ingredient pairs sharing at least one base effect
+	};
+
+	std::string_view to_string(Randomizer::SHUFFLE_METHOD a_method)
+	{
+		switch (a_method) {
+		case Randomizer::SHUFFLE_METHOD::kSwap:
+			return "swap";
+		case Randomizer::SHUFFLE_METHOD::kShuffle:
+			return "shuffle";
+		case Randomizer::SHUFFLE_METHOD::kConstrained:
+			return "constrained";
+		case Randomizer::SHUFFLE_METHOD::kPermutation:
+			return "permutation";
+		default:
+			return "unknown";
+		}
+	}
+
+	std::string_view to_string(const Metrics& a_metrics)
+	{
+		switch (a_metrics.status) {
+		case Randomizer::ShuffleResult::STATUS::kImpossible:
+			return "impossible";
+		case Randomizer::ShuffleResult::STATUS::kUnsatisfiable:
+			return "unsatisfiable";
+		default:
+			return a_metrics.constructed ? "built" : "ok";
+		}
+	}
+
+	void measure(const Randomizer::EffectTable& a_table, const Randomizer::IngredientEffectGroups& a_effectGroups, Metrics& a_metrics)
+	{
+		// ingredients per base effect, CSR
+		const auto               baseCount = a_table.GetBaseCount();
+		std::vector<std::size_t> offsets(baseCount + 1, 0);
+		for (const auto& effectGroup : a_effectGroups) {
+			for (const auto effect : effectGroup) {
+				offsets[a_table.GetBase(effect) + 1]++;
+			}
+		}
+		for (std::size_t base = 0; base < baseCount; ++base) {
+			if (const auto count = offsets[base + 1]; count > 0) {
+				a_metrics.effects++;
+				a_metrics.minPerEffect = a_metrics.effects == 1 ? count : std::min(a_metrics.minPerEffect, count);
+				a_metrics.maxPerEffect = std::max(a_metrics.maxPerEffect, count);
+				a_metrics.singleEffects += count == 1;
+			}
+			offsets[base + 1] += offsets[base];
+		}
+
+		std::vector<std::uint32_t> ingredients(offsets.back());
+		{
+			auto next = offsets;
+			for (std::uint32_t i = 0; i < a_effectGroups.size(); ++i) {
+				for (const auto effect : a_effectGroups[i]) {
+					ingredients[next[a_table.GetBase(effect)]++] = i;
+				}
+			}
+		}
+
+		// each partner counted once, however many effects the pair shares
+		std::vector<std::uint32_t> seenBy(a_effectGroups.size(), std::numeric_limits<std::uint32_t>::max());
+		for (std::uint32_t i = 0; i < a_effectGroups.size(); ++i) {
+			for (const auto effect : a_effectGroups[i]) {
+				const auto base = a_table.GetBase(effect);
+				for (auto j = offsets[base]; j < offsets[base + 1]; ++j) {
+					if (const auto partner = ingredients[j]; partner > i && seenBy[partner] != i) {
+						seenBy[partner] = i;
+						a_metrics.craftablePairs++;
+					}
+				}
+			}
+		}
+	}
+
+	template <class T>
+	bool parse_num(std::string_view a_str, T& a_out)
+	{
+		return std::from_chars(a_str.data(), a_str.data() + a_str.size(), a_out).ec == std::errc{};
+	}
+
+	bool parse_method(std::string_view a_str, Randomizer::SHUFFLE_METHOD& a_out)
+	{
+		for (const auto method : { Randomizer::SHUFFLE_METHOD::kSwap, Randomizer::SHUFFLE_METHOD::kShuffle, Randomizer::SHUFFLE_METHOD::kConstrained, Randomizer::SHUFFLE_METHOD::kPermutation }) {
+			if (a_str == to_string(method)) {
+				a_out = method;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool parse_args(int a_argc, char* a_argv[], Settings& a_settings)
+	{
+		for (int i = 1; i + 1 < a_argc; i += 2) {
+			const std::string_view key = a_argv[i];
+			const std::string_view value = a_argv[i + 1];
+
+			bool ok = false;
+			if (key == "--dump") {
+				a_settings.dumpPath = value;
+				ok = true;
+			} else if (key == "--out") {
+				a_settings.outDirectory = value;
+				ok = true;
+			} else if (key == "--seed") {
+				ok = parse_num(value, a_settings.firstSeed);
+			} else if (key == "--count") {
+				ok = parse_num(value, a_settings.seedCount) && a_settings.seedCount > 0;
+			} else if (key == "--method") {
+				ok = parse_method(value, a_settings.method);
+			} else if (key == "--min") {
+				ok = parse_num(value, a_settings.constraints.minPerBase);
+			} else if (key == "--max") {
+				ok = parse_num(value, a_settings.constraints.maxPerBase);
+			} else if (key == "--threads") {
+				ok = parse_num(value, a_settings.threadCount);
+			} else if (key == "--top") {
+				ok = parse_num(value, a_settings.top);
+			}
+
+			if (!ok) {
+				return false;
+			}
+		}
+		return a_argc % 2 == 1 && !a_settings.dumpPath.empty();
+	}
+}
+
+int main(int a_argc, char* a_argv[])
+{
+	Settings settings;
+	if (!parse_args(a_argc, a_argv, settings)) {
+		std::println("usage : RandomizerBatch --dump FILE [--out DIR] [--seed FIRST] [--count N] [--method swap|shuffle|constrained|permutation] [--min N] [--max N] [--threads N] [--top N]");
+		return 1;
+	}
+
+	const auto dump = Randomizer::read_ingredient_dump(settings.dumpPath);
+	if (!dump) {
+		std::println("couldn't read ingredient dump {}", settings.dumpPath.string());
+		return 1;
+	}
+
+	const auto table = dump->BuildEffectTable();
+	const auto groupCount = dump->effectGroups.size();
+	std::println("{} : {} ingredients, {} effects, {} base effects", settings.dumpPath.string(), groupCount, table.size(), table.GetBaseCount());
+
+	std::error_code ec;
+	std::filesystem::create_directories(settings.outDirectory, ec);
+
+	std::ofstream results(settings.outDirectory / "results.bin", std::ios::binary | std::ios::trunc);
+	std::ofstream metricsFile(settings.outDirectory / "metrics.csv", std::ios::trunc);
+	if (!results || !metricsFile) {
+		std::println("couldn't create output files in {}", settings.outDirectory.string());
+		return 1;
+	}
+
+	const auto write_bytes = [&](const Randomizer::Bytes& a_bytes) {
+		results.write(reinterpret_cast<const char*>(a_bytes.data()), static_cast<std::streamsize>(a_bytes.size()));
+	};
+
+	{
+		using namespace Randomizer::serialize;
+		Randomizer::Bytes header;
+		put(header, resultsMagic);
+		put(header, resultsVersion);
+		put(header, dump->GetHash());
+		put(header, static_cast<std::uint32_t>(settings.method));
+		put(header, static_cast<std::uint32_t>(groupCount));
+		put(header, settings.seedCount);
+		write_bytes(header);
+	}
+	std::println(metricsFile, "seed,status,repairs,rebalanced,effects,minPerEffect,maxPerEffect,singleEffects,craftablePairs");
+
+	Randomizer::ThreadPool pool(settings.threadCount);
+
+	std::vector<Metrics>                            metrics;
+	std::vector<Randomizer::IngredientEffectGroups> batch;
+	metrics.reserve(settings.seedCount);
+
+	const auto start = std::chrono::steady_clock::now();
+	for (std::uint64_t batchStart = 0; batchStart < settings.seedCount; batchStart += seedsPerBatch) {
+		const auto batchSize = std::min<std::uint64_t>(seedsPerBatch, settings.seedCount - batchStart);
+		const auto firstMetric = metrics.size();
+		metrics.resize(firstMetric + batchSize);
+		batch.assign(batchSize, {});
+
+		pool.ParallelFor(batchSize, [&](std::size_t a_index) {
+			auto& effectGroups = batch[a_index];
+			auto& metric = metrics[firstMetric + a_index];
+
+			effectGroups = dump->effectGroups;
+			metric.seed = settings.firstSeed + batchStart + a_index;
+
+			const auto result = Randomizer::shuffle_effect_groups(metric.seed, settings.method, table, effectGroups, nullptr, settings.constraints);
+			metric.status = result.status;
+			metric.repairs = result.repairs;
+			metric.constructed = result.constructed;
+			metric.rebalanced = result.rebalanced;
+			measure(table, effectGroups, metric);
+		});
+
+		// written in seed order
+		for (std::size_t i = 0; i < batchSize; ++i) {
+			const auto& metric = metrics[firstMetric + i];
+
+			Randomizer::Bytes record;
+			record.reserve(9 + groupCount * sizeof(Randomizer::IngredientEffects));
+			Randomizer::serialize::put(record, metric.seed);
+			Randomizer::serialize::put(record, static_cast<std::uint8_t>(metric.status));
+			const auto groups = std::as_bytes(std::span(batch[i]));
+			record.insert(record.end(), groups.begin(), groups.end());
+			write_bytes(record);
+
+			std::println(metricsFile, "{},{},{},{},{},{},{},{},{}",
+				metric.seed, to_string(metric), metric.repairs, metric.rebalanced,
+				metric.effects, metric.minPerEffect, metric.maxPerEffect, metric.singleEffects, metric.craftablePairs);
+		}
+	}
+	const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	const auto failed = std::ranges::count_if(metrics, [](const Metrics& a_metric) { return a_metric.status != Randomizer::ShuffleResult::STATUS::kSuccess; });
+	std::println("{} seeds ({}) in {:.2f}s on {} threads, {} failed", settings.seedCount, to_string(settings.method), elapsed, pool.GetThreadCount() + 1, failed);
+
+	// fewest uncraftable effects first, then most craftable pairs, then lowest seed
+	std::ranges::sort(metrics, [](const Metrics& a_lhs, const Metrics& a_rhs) {
+		return std::tuple(a_lhs.status != Randomizer::ShuffleResult::STATUS::kSuccess, a_lhs.singleEffects, -static_cast<std::int64_t>(a_lhs.craftablePairs), a_lhs.seed) <
+		       std::tuple(a_rhs.status != Randomizer::ShuffleResult::STATUS::kSuccess, a_rhs.singleEffects, -static_cast<std::int64_t>(a_rhs.craftablePairs), a_rhs.seed);
+	});
+
+	std::println("{:>20} {:>8} {:>8} {:>8} {:>10} {:>10}", "seed", "status", "repairs", "single", "pairs", "per effect");
+	for (const auto& metric : metrics | std::views::take(settings.top)) {
+		std::println("{:>20} {:>8} {:>8} {:>8} {:>10} {:>4}-{:<5}", metric.seed, to_string(metric), metric.repairs, metric.singleEffects, metric.craftablePairs, metric.minPerEffect, metric.maxPerEffect);
+	}
+
+	return 0;
+}
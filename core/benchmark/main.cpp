@@ -0,0 +1,296 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <print>
+#include <random>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Randomizer/Apply.h"
+#include "Randomizer/EffectTable.h"
+#include "Randomizer/Eligibility.h"
+#include "Randomizer/KnownEffects.h"
+#include "Randomizer/Shuffle.h"
+
+// Synthetic load orders for timing the randomizer outside the game.
+// Effect pools are Zipf-skewed : a handful of effects (Restore Health, Fortify X...) sit on a large share of ingredients.
+
+namespace
+{
+	struct Settings
+	{
+		std::vector<std::size_t> sizes{ 100, 1000, 10000, 100000 };
+		std::uint32_t            repeats{ 5 };
+		std::uint64_t            seed{ 12345 };
+		std::uint32_t            saveCount{ 50 };
+		std::size_t              threadCount{ std::max(1u, std::thread::hardware_concurrency()) - 1 };
+		double                   skew{ 1.07 };
+	};
+
+	struct SyntheticIngredient
+	{
+		std::string                         editorID;
+		Randomizer::IngredientInstances     effects{};
+		std::uint16_t                       knownEffectFlags{ 0 };
+		bool                                blacklisted{ false };
+	};
+
+	struct LoadOrder
+	{
+		std::vector<SyntheticIngredient>       ingredients;
+		Randomizer::EffectTable                effectTable;
+		Randomizer::IngredientEffectGroups     effectGroups;
+		Randomizer::EffectInstances            effectInstances;
+		Randomizer::EligibilityIndex           eligibleIngredients;
+		std::vector<Randomizer::IngredientKey> ingredientKeys;  // slot -> key
+		std::vector<std::string>               editorIDs;       // slot -> EDID
+		std::size_t                            baseEffectCount{ 0 };
+		Randomizer::InstanceID                 instanceCount{ 0 };
+	};
+
+	std::size_t get_base_effect_count(std::size_t a_ingredientCount)
+	{
+		// ~55 vanilla alchemy effects, modded setups add a few hundred more
+		return std::max<std::size_t>(60, static_cast<std::size_t>(std::sqrt(static_cast<double>(a_ingredientCount)) * 6.0));
+	}
+
+	LoadOrder build_load_order(std::size_t a_ingredientCount, double a_skew, std::uint64_t a_seed)
+	{
+		LoadOrder loadOrder;
+		loadOrder.baseEffectCount = get_base_effect_count(a_ingredientCount);
+
+		std::vector<double> weights(loadOrder.baseEffectCount);
+		for (std::size_t i = 0; i < weights.size(); ++i) {
+			weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), a_skew);
+		}
+
+		std::mt19937_64                        rng(a_seed);
+		std::discrete_distribution<std::size_t> baseDist(weights.begin(), weights.end());
+		std::bernoulli_distribution            blacklistDist(0.01);
+		std::bernoulli_distribution            knownDist(0.25);
+		std::uniform_int_distribution<int>     magnitudeDist(1, 3);  // most effects come in a couple of strengths
+
+		loadOrder.ingredients.resize(a_ingredientCount);
+		loadOrder.eligibleIngredients = Randomizer::EligibilityIndex(a_ingredientCount);
+		loadOrder.effectGroups.reserve(a_ingredientCount);
+
+		Randomizer::InstanceID instanceID = 0;
+		for (std::size_t i = 0; i < a_ingredientCount; ++i) {
+			auto& ingredient = loadOrder.ingredients[i];
+			ingredient.editorID = "SyntheticIngredient" + std::to_string(i);
+			ingredient.blacklisted = blacklistDist(rng);
+			ingredient.knownEffectFlags = knownDist(rng) ? static_cast<std::uint16_t>(rng() & 0xF) : 0;
+
+			// vanilla ingredients never repeat a base effect
+			std::array<Randomizer::BaseEffectID, 4> bases{};
+			for (std::size_t j = 0; j < 4; ++j) {
+				do {
+					bases[j] = static_cast<Randomizer::BaseEffectID>(baseDist(rng));
+				} while (std::find(bases.begin(), bases.begin() + j, bases[j]) != bases.begin() + j);
+			}
+
+			if (ingredient.blacklisted) {
+				continue;
+			}
+
+			Randomizer::IngredientEffects effectGroup{};
+			for (std::size_t j = 0; j < 4; ++j) {
+				ingredient.effects[j] = instanceID++;
+				effectGroup[j] = *loadOrder.effectTable.Intern({ .base = bases[j], .magnitude = static_cast<float>(magnitudeDist(rng) * 5) });
+			}
+			loadOrder.effectGroups.push_back(effectGroup);
+			loadOrder.eligibleIngredients.Add(static_cast<std::uint32_t>(i));
+			loadOrder.ingredientKeys.push_back({ "Synthetic" + std::to_string(i / 512) + ".esp", static_cast<std::uint32_t>(i % 512) });
+			loadOrder.editorIDs.push_back(ingredient.editorID);
+		}
+
+		loadOrder.effectInstances = Randomizer::EffectInstances(loadOrder.effectGroups, loadOrder.effectTable.size());
+		loadOrder.instanceCount = instanceID;
+
+		return loadOrder;
+	}
+
+	template <class F>
+	double time_ms(F&& a_func)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		a_func();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	double median(std::vector<double>& a_samples)
+	{
+		std::ranges::sort(a_samples);
+		return a_samples[a_samples.size() / 2];
+	}
+
+	std::string_view to_string(Randomizer::SHUFFLE_METHOD a_method)
+	{
+		switch (a_method) {
+		case Randomizer::SHUFFLE_METHOD::kSwap:
+			return "swap";
+		case Randomizer::SHUFFLE_METHOD::kShuffle:
+			return "shuffle";
+		case Randomizer::SHUFFLE_METHOD::kConstrained:
+			return "constrained";
+		case Randomizer::SHUFFLE_METHOD::kPermutation:
+			return "permutation";
+		default:
+			return "unknown";
+		}
+	}
+
+	void run(const Settings& a_settings, Randomizer::ThreadPool& a_pool, std::size_t a_size, Randomizer::SHUFFLE_METHOD a_method)
+	{
+		auto loadOrder = build_load_order(a_size, a_settings.skew, a_settings.seed);
+
+		const auto saveDirectory = std::filesystem::temp_directory_path() / "RandomizerBenchmark";
+
+		Randomizer::KnownEffects knownEffects;
+		knownEffects.Open(saveDirectory);
+		knownEffects.SetIngredients(loadOrder.ingredientKeys, loadOrder.editorIDs);
+
+		const auto record_known_effects = [&] {
+			for (std::uint32_t slot = 0; slot < loadOrder.eligibleIngredients.size(); ++slot) {
+				if (const auto& ingredient = loadOrder.ingredients[loadOrder.eligibleIngredients.GetPosition(slot)]; ingredient.knownEffectFlags != 0) {
+					knownEffects.Record(slot, ingredient.knownEffectFlags);
+				}
+			}
+		};
+
+		for (std::uint32_t i = 0; i < a_settings.saveCount; ++i) {
+			record_known_effects();
+			knownEffects.Save("Save" + std::to_string(i));
+		}
+		knownEffects.Flush();
+
+		std::vector<double> shuffleSamples;
+		std::vector<double> applySamples;
+		std::vector<double> saveSamples;
+		Randomizer::ShuffleResult  result;
+		Randomizer::AppliedEffects applied(loadOrder.effectGroups);
+		bool                       unique = true;
+
+		for (std::uint32_t i = 0; i < a_settings.repeats; ++i) {
+			auto effectGroups = loadOrder.effectGroups;
+
+			shuffleSamples.push_back(time_ms([&] {
+				if (a_method == Randomizer::SHUFFLE_METHOD::kPermutation) {
+					// only the seed and patches are kept, groups are resolved again when applied
+					const auto keyed = Randomizer::make_keyed_shuffle(a_settings.seed + i, loadOrder.effectTable, loadOrder.effectGroups, &a_pool, result);
+					keyed.Materialize(loadOrder.effectGroups, effectGroups, &a_pool);
+				} else {
+					result = Randomizer::shuffle_effect_groups(a_settings.seed + i, a_method, loadOrder.effectTable, effectGroups, &a_pool);
+				}
+			}));
+			unique &= a_method == Randomizer::SHUFFLE_METHOD::kSwap || Randomizer::is_distribution_unique(loadOrder.effectTable, effectGroups);
+
+			applySamples.push_back(time_ms([&] {
+				// stands in for the host copying effect objects
+				std::vector<std::pair<Randomizer::EffectIndex, Randomizer::InstanceID>> added;
+				for (const auto& [effect, count] : loadOrder.effectInstances.GetShortfall(effectGroups)) {
+					for (std::uint32_t j = 0; j < count; ++j) {
+						added.emplace_back(effect, loadOrder.instanceCount++);
+					}
+				}
+				if (!added.empty()) {
+					loadOrder.effectInstances.Add(added);
+				}
+				applied.Apply(effectGroups, loadOrder.effectInstances, [&](std::uint32_t a_slot, const Randomizer::IngredientInstances& a_instances) {
+					loadOrder.ingredients[loadOrder.eligibleIngredients.GetPosition(a_slot)].effects = a_instances;
+				});
+			}));
+
+			saveSamples.push_back(time_ms([&] {
+				record_known_effects();
+				knownEffects.Save("CurrentSave");
+			}));
+		}
+
+		knownEffects.Flush();
+		std::filesystem::remove_all(saveDirectory);
+
+		std::string_view status = "ok";
+		if (!result.success()) {
+			status = "failed";
+		} else if (!unique) {
+			status = "dupes";
+		} else if (result.constructed) {
+			status = "built";
+		}
+
+		std::println("{:>8} {:>8} {:>12} {:>12.3f} {:>12.3f} {:>12.3f} {:>8} {:>8}",
+			a_size, loadOrder.baseEffectCount, to_string(a_method),
+			median(shuffleSamples), median(applySamples), median(saveSamples),
+			result.repairs, status);
+	}
+
+	template <class T>
+	bool parse_num(std::string_view a_str, T& a_out)
+	{
+		return std::from_chars(a_str.data(), a_str.data() + a_str.size(), a_out).ec == std::errc{};
+	}
+
+	bool parse_args(int a_argc, char* a_argv[], Settings& a_settings)
+	{
+		for (int i = 1; i + 1 < a_argc; i += 2) {
+			const std::string_view key = a_argv[i];
+			const std::string_view value = a_argv[i + 1];
+
+			bool ok = false;
+			if (key == "--sizes") {
+				a_settings.sizes.clear();
+				for (const auto size : value | std::views::split(',')) {
+					std::size_t num = 0;
+					if (!parse_num(std::string_view(size.begin(), size.end()), num)) {
+						return false;
+					}
+					a_settings.sizes.push_back(num);
+				}
+				ok = !a_settings.sizes.empty();
+			} else if (key == "--repeats") {
+				ok = parse_num(value, a_settings.repeats) && a_settings.repeats > 0;
+			} else if (key == "--seed") {
+				ok = parse_num(value, a_settings.seed);
+			} else if (key == "--threads") {
+				ok = parse_num(value, a_settings.threadCount);
+			} else if (key == "--saves") {
+				ok = parse_num(value, a_settings.saveCount);
+			} else if (key == "--skew") {
+				ok = parse_num(value, a_settings.skew);
+			}
+
+			if (!ok) {
+				return false;
+			}
+		}
+		return a_argc % 2 == 1;
+	}
+}
+
+int main(int a_argc, char* a_argv[])
+{
+	Settings settings;
+	if (!parse_args(a_argc, a_argv, settings)) {
+		std::println("usage : RandomizerBenchmark [--sizes 100,1000,...] [--repeats N] [--seed N] [--threads N] [--saves N] [--skew S]");
+		return 1;
+	}
+
+	Randomizer::ThreadPool pool(settings.threadCount);
+
+	std::println("{:>8} {:>8} {:>12} {:>12} {:>12} {:>12} {:>8} {:>8}", "size", "effects", "method", "shuffle(ms)", "apply(ms)", "save(ms)", "repairs", "status");
+
+	for (const auto size : settings.sizes) {
+		for (const auto method : { Randomizer::SHUFFLE_METHOD::kSwap, Randomizer::SHUFFLE_METHOD::kShuffle, Randomizer::SHUFFLE_METHOD::kConstrained, Randomizer::SHUFFLE_METHOD::kPermutation }) {
+			run(settings, pool, size, method);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Randomizer/EffectTable.h"
+#include "Randomizer/Types.h"
+
+namespace Randomizer
+{
+	using IngredientInstances = std::array<InstanceID, 4>;
+
+	// Hands each eligible ingredient slot the effect objects of its effect group.
+	// a_apply(std::uint32_t slot, const IngredientInstances&), see EligibilityIndex for slot -> ingredient
+	template <class Apply>
+	void apply_effect_groups(const IngredientEffectGroups& a_effectGroups, const EffectInstances& a_instances, Apply&& a_apply)
+	{
+		EffectInstances::Cursor cursor(a_instances);
+
+		for (std::uint32_t slot = 0; slot < a_effectGroups.size(); ++slot) {
+			const auto& effectGroup = a_effectGroups[slot];
+			a_apply(slot, IngredientInstances{ cursor(effectGroup[0]), cursor(effectGroup[1]), cursor(effectGroup[2]), cursor(effectGroup[3]) });
+		}
+	}
+
+	// The effect and effect object each slot currently holds in the host. Apply() only hands out the ingredient slots that change :
+	// unchanged effect slots keep their object, and objects freed by changed slots are reused by effect before unused ones.
+	class AppliedEffects
+	{
+	public:
+		AppliedEffects() = default;
+		// the unshuffled load order, effect slot N holds object N
+		explicit AppliedEffects(const IngredientEffectGroups& a_original);
+
+		// a_apply(std::uint32_t slot, const IngredientInstances&) per changed ingredient slot, returns how many changed
+		template <class F>
+		std::size_t Apply(const IngredientEffectGroups& a_effectGroups, const EffectInstances& a_instances, F&& a_apply)
+		{
+			const auto changed = Update(a_effectGroups, a_instances);
+			for (const auto slot : changed) {
+				a_apply(slot, instances[slot]);
+			}
+			return changed.size();
+		}
+
+		// the host moved the objects of two effect slots itself
+		void Swap(std::uint32_t a_effectSlot, std::uint32_t a_partnerSlot);
+
+		[[nodiscard]] const IngredientEffectGroups& GetEffectGroups() const { return effectGroups; }
+
+	private:
+		std::vector<std::uint32_t> Update(const IngredientEffectGroups& a_effectGroups, const EffectInstances& a_instances);
+
+		// members
+		IngredientEffectGroups           effectGroups;
+		std::vector<IngredientInstances> instances;  // same layout as effectGroups
+	};
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace Randomizer
+{
+	// [Blacklist] entries from every config. An entry is an EditorID, an EditorID prefix ending in '*',
+	// or a plugin name (.esp/.esm/.esl) that blacklists every ingredient it adds. Case-insensitive.
+	struct BlacklistRules
+	{
+		enum class RULE
+		{
+			kEditorID,
+			kPrefix,
+			kPlugin
+		};
+
+		void Add(std::string_view a_entry);
+		void Merge(const BlacklistRules& a_rules);
+
+		[[nodiscard]] std::size_t size() const { return editorIDs.size() + prefixes.size() + plugins.size(); }
+		[[nodiscard]] bool        empty() const { return size() == 0; }
+
+		// members, lowercase
+		std::vector<std::string> editorIDs;
+		std::vector<std::string> prefixes;  // without the '*'
+		std::vector<std::string> plugins;
+	};
+
+	struct BlacklistMatch
+	{
+		BlacklistRules::RULE rule;
+		std::string_view     entry;  // the matching rule, owned by the matcher
+	};
+
+	// every rule compiled into one lookup : hashed EditorIDs and plugins, and prefixes sorted with
+	// redundant ones dropped, so a single binary search finds the only candidate
+	class BlacklistMatcher
+	{
+	public:
+		BlacklistMatcher() = default;
+		explicit BlacklistMatcher(const BlacklistRules& a_rules);
+
+		[[nodiscard]] std::optional<BlacklistMatch> Match(std::string_view a_file, std::string_view a_editorID) const;
+
+	private:
+		// members
+		std::unordered_set<std::string> editorIDs;
+		std::unordered_set<std::string> plugins;
+		std::vector<std::string>        prefixes;
+	};
+
+	// parsed rules keyed by the configs they came from. Matching runs every launch, plugins can change in place
+	struct BlacklistCache
+	{
+		std::uint64_t  configHash{ 0 };
+		BlacklistRules rules;
+	};
+
+	// paths, sizes and modification times, any edit, addition or removal changes it
+	[[nodiscard]] std::uint64_t hash_configs(std::span<const std::string> a_paths);
+
+	[[nodiscard]] std::optional<BlacklistCache> read_blacklist_cache(const std::filesystem::path& a_path);
+	bool                                        write_blacklist_cache(const std::filesystem::path& a_path, const BlacklistCache& a_cache);
+}
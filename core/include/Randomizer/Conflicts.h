@@ -0,0 +1,51 @@
+#pragma once
+
+#include <bit>
+#include <span>
+
+#include "Randomizer/Types.h"
+
+namespace Randomizer
+{
+	// four 16-bit base effects in one word, lane N = slot N
+	[[nodiscard]] inline std::uint64_t pack_bases(const IngredientEffects& a_effectGroup, std::span<const BaseIndex> a_bases)
+	{
+		return static_cast<std::uint64_t>(a_bases[a_effectGroup[0]]) |
+		       static_cast<std::uint64_t>(a_bases[a_effectGroup[1]]) << 16 |
+		       static_cast<std::uint64_t>(a_bases[a_effectGroup[2]]) << 32 |
+		       static_cast<std::uint64_t>(a_bases[a_effectGroup[3]]) << 48;
+	}
+
+	// compares all six lane pairs without branching : rotating by one lane pairs (0,1) (1,2) (2,3) (3,0), by two lanes (0,2) (1,3)
+	[[nodiscard]] constexpr bool has_duplicate_base(std::uint64_t a_packedBases)
+	{
+		constexpr auto has_zero_lane = [](std::uint64_t a_value) {
+			return ((a_value - 0x0001000100010001) & ~a_value & 0x8000800080008000) != 0;
+		};
+		return has_zero_lane(a_packedBases ^ std::rotr(a_packedBases, 16)) | has_zero_lane(a_packedBases ^ std::rotr(a_packedBases, 32));
+	}
+
+	[[nodiscard]] inline bool has_duplicate_base(const IngredientEffects& a_effectGroup, std::span<const BaseIndex> a_bases)
+	{
+		return has_duplicate_base(pack_bases(a_effectGroup, a_bases));
+	}
+
+	// Live set of effect groups holding a duplicate base effect. Update() after touching a group keeps the count exact in O(1).
+	class ConflictIndex
+	{
+	public:
+		ConflictIndex(std::span<const IngredientEffects> a_effectGroups, std::span<const BaseIndex> a_bases);
+
+		void Update(std::size_t a_group);
+
+		[[nodiscard]] bool        IsConflicted(std::size_t a_group) const { return conflicted[a_group] != 0; }
+		[[nodiscard]] std::size_t GetCount() const { return count; }
+
+	private:
+		// members
+		std::span<const IngredientEffects> effectGroups;
+		std::span<const BaseIndex>         bases;
+		std::vector<std::uint8_t>          conflicted;
+		std::size_t                        count{ 0 };
+	};
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <optional>
+#include <span>
+#include <unordered_map>
+
+#include "Randomizer/Types.h"
+
+namespace Randomizer
+{
+	// everything that tells two effects apart in game, identical effects are interchangeable
+	struct EffectData
+	{
+		BaseEffectID  base{ 0 };
+		float         magnitude{ 0.0f };
+		std::uint32_t area{ 0 };
+		std::uint32_t duration{ 0 };
+		std::uint64_t conditions{ 0 };  // host handle to the effect's conditions, 0 if unconditional
+
+		bool operator==(const EffectData&) const = default;
+	};
+
+	// Interns effects into 16-bit indices, so shuffles move two bytes per slot
+	class EffectTable
+	{
+	public:
+		static constexpr std::size_t maxSize = std::size_t(1) << (sizeof(EffectIndex) * 8);
+
+		// nullopt if the table is full
+		std::optional<EffectIndex> Intern(const EffectData& a_effect);
+
+		[[nodiscard]] const EffectData& Get(EffectIndex a_index) const { return effects[a_index]; }
+		[[nodiscard]] BaseIndex         GetBase(EffectIndex a_index) const { return bases[a_index]; }
+		[[nodiscard]] BaseEffectID      GetBaseID(BaseIndex a_base) const { return baseIDs[a_base]; }
+		[[nodiscard]] std::span<const BaseIndex> GetBases() const { return bases; }
+
+		[[nodiscard]] std::size_t size() const { return effects.size(); }
+		[[nodiscard]] std::size_t GetBaseCount() const { return baseIDs.size(); }
+
+	private:
+		struct Hash
+		{
+			std::size_t operator()(const EffectData& a_effect) const;
+		};
+
+		// members
+		std::vector<EffectData>                             effects;
+		std::vector<BaseIndex>                              bases;    // EffectIndex -> BaseIndex
+		std::vector<BaseEffectID>                           baseIDs;  // BaseIndex -> BaseEffectID
+		std::unordered_map<EffectData, EffectIndex, Hash>   effectLookup;
+		std::unordered_map<BaseEffectID, BaseIndex>         baseLookup;
+	};
+
+	// The host's effect objects, grouped by interned effect. Shuffles only move interned indices,
+	// so each slot takes the next unused object of its effect and every object is used exactly once.
+	class EffectInstances
+	{
+	public:
+		EffectInstances() = default;
+		EffectInstances(const IngredientEffectGroups& a_original, std::size_t a_effectCount);
+
+		// effects a_effectGroups uses more often than there are objects for, and how many more it needs
+		[[nodiscard]] std::vector<std::pair<EffectIndex, std::uint32_t>> GetShortfall(const IngredientEffectGroups& a_effectGroups) const;
+		// registers host objects created to cover a shortfall, usually copies of GetFirst(effect)
+		void                     Add(std::span<const std::pair<EffectIndex, InstanceID>> a_instances);
+		[[nodiscard]] InstanceID GetFirst(EffectIndex a_effect) const { return instances[offsets[a_effect]]; }
+
+		[[nodiscard]] std::span<const InstanceID> GetInstances(EffectIndex a_effect) const { return std::span(instances).subspan(offsets[a_effect], offsets[a_effect + 1] - offsets[a_effect]); }
+		[[nodiscard]] std::size_t                 GetEffectCount() const { return offsets.size() - 1; }
+		[[nodiscard]] std::size_t                 size() const { return instances.size(); }  // instance IDs run from 0 to size() - 1
+
+		class Cursor
+		{
+		public:
+			explicit Cursor(const EffectInstances& a_instances) :
+				instances(a_instances.instances),
+				next(a_instances.offsets.begin(), a_instances.offsets.end() - 1)
+			{}
+
+			InstanceID operator()(EffectIndex a_effect) { return instances[next[a_effect]++]; }
+
+		private:
+			std::span<const InstanceID> instances;
+			std::vector<std::uint32_t>  next;
+		};
+
+	private:
+		// members
+		std::vector<std::uint32_t> offsets;    // EffectIndex -> first instance, CSR
+		std::vector<InstanceID>    instances;  // grouped by EffectIndex
+	};
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Randomizer
+{
+	// Ingredients taking part in the randomizer, by position in the host's ingredient list.
+	// Slot N is the Nth eligible ingredient and owns effect group N.
+	class EligibilityIndex
+	{
+	public:
+		EligibilityIndex() = default;
+		// a_positionCount : size of the host's ingredient list, an upper bound on the slot count
+		explicit EligibilityIndex(std::size_t a_positionCount) { positions.reserve(a_positionCount); }
+
+		void Add(std::uint32_t a_position) { positions.push_back(a_position); }
+
+		[[nodiscard]] std::uint32_t                 GetPosition(std::uint32_t a_slot) const { return positions[a_slot]; }
+		[[nodiscard]] std::span<const std::uint32_t> GetPositions() const { return positions; }
+		[[nodiscard]] std::size_t                   size() const { return positions.size(); }
+		[[nodiscard]] bool                          empty() const { return positions.empty(); }
+
+	private:
+		// members
+		std::vector<std::uint32_t> positions;  // slot -> position
+	};
+}
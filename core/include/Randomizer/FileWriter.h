@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Randomizer
+{
+	using Bytes = std::vector<std::byte>;
+
+	// writes a_data next to a_path and renames it over a_path, so a crash leaves either the old or the new file
+	bool write_file_atomic(const std::filesystem::path& a_path, std::span<const std::byte> a_data);
+
+	// Background writer thread. Only the latest queued request per path is kept, jobs run in the order they were last queued.
+	// A write can name a file it depends on, it's held back until that file is on disk. Failed writes, and anything
+	// depending on them, are retried with the next batch or after a backoff delay. Pending jobs are drained on destruction.
+	class FileWriter
+	{
+	public:
+		// called on the writer thread, once when a job starts being held back and once if it's dropped on destruction
+		using HeldCallback = std::function<void(const std::filesystem::path& a_path, bool a_dropped)>;
+
+		explicit FileWriter(HeldCallback a_onHeld = {});
+		~FileWriter();
+
+		FileWriter(const FileWriter&) = delete;
+		FileWriter(FileWriter&&) = delete;
+		FileWriter& operator=(const FileWriter&) = delete;
+		FileWriter& operator=(FileWriter&&) = delete;
+
+		void Write(std::filesystem::path a_path, Bytes a_data, std::filesystem::path a_dependency = {});
+		void Remove(std::filesystem::path a_path);
+
+		// blocks until everything queued so far has been attempted
+		void Flush();
+
+	private:
+		struct Job
+		{
+			std::filesystem::path path;
+			std::optional<Bytes>  data;  // nullopt removes the file
+			std::filesystem::path dependency;
+		};
+
+		void Queue(Job a_job);
+		void WriterLoop(std::stop_token a_stop);
+		// runs what it can, returns the jobs that failed or are still waiting on a dependency, in order
+		static std::vector<Job> run_jobs(std::vector<Job> a_jobs);
+
+		static constexpr std::chrono::milliseconds minRetryDelay{ 1000 };
+		static constexpr std::chrono::milliseconds maxRetryDelay{ 60000 };
+
+		// members
+		HeldCallback                onHeld;
+		std::mutex                  lock;
+		std::condition_variable_any wake;
+		std::condition_variable_any drained;
+		std::vector<Job>            jobs;
+		bool                        busy{ false };
+		std::jthread                thread;  // declared last, stops before the queue goes away
+	};
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Randomizer/EffectTable.h"
+#include "Randomizer/KnownEffects.h"
+#include "Randomizer/Types.h"
+
+namespace Randomizer
+{
+	// Eligible ingredients and their effects as the host sees them after data load, for shuffling outside the game.
+	// Effects are listed in EffectTable order, interning them again in that order rebuilds the same indices.
+	struct IngredientDump
+	{
+		std::vector<IngredientKey>                        ingredients;  // slot -> key
+		std::vector<std::string>                          editorIDs;    // slot -> EDID
+		std::vector<EffectData>                           effects;      // conditions replaced by an ordinal, 0 if unconditional
+		std::vector<std::pair<BaseEffectID, std::string>> baseEffects;  // base effect -> EDID, for readable output
+		IngredientEffectGroups                            effectGroups;
+
+		[[nodiscard]] EffectTable   BuildEffectTable() const;
+		[[nodiscard]] std::uint64_t GetHash() const;
+	};
+
+	// a_editorIDs and a_baseEffects are optional, a_table supplies the effects
+	[[nodiscard]] IngredientDump make_ingredient_dump(const EffectTable& a_table, const IngredientEffectGroups& a_effectGroups, std::vector<IngredientKey> a_ingredients, std::vector<std::string> a_editorIDs = {}, std::vector<std::pair<BaseEffectID, std::string>> a_baseEffects = {});
+
+	bool                                        write_ingredient_dump(const std::filesystem::path& a_path, const IngredientDump& a_dump);
+	[[nodiscard]] std::optional<IngredientDump> read_ingredient_dump(const std::filesystem::path& a_path);
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Randomizer/FileWriter.h"
+
+namespace Randomizer
+{
+	using IngredientKnownEffectsMap = std::unordered_map<std::string, std::uint16_t>;  // IngredientEDID -> KnownEffectFlags, legacy JSON file
+
+	// plugin name + FormID without the load order index, stable across load order changes
+	struct IngredientKey
+	{
+		std::string   file;
+		std::uint32_t localFormID{ 0 };
+	};
+
+	struct KnownEffectsEntry
+	{
+		std::uint32_t file{ 0 };  // index into KnownEffectsRecord::files
+		std::uint32_t localFormID{ 0 };
+		std::uint16_t flags{ 0 };
+	};
+
+	struct KnownEffectsRecord
+	{
+		std::vector<std::string>       files;
+		std::vector<KnownEffectsEntry> entries;
+	};
+
+	// Per-save record of which ingredient effects the player had learned.
+	// Saves refer to a content-addressed snapshot shared across a playthrough, plus a small delta against it.
+	// Each save is stored in its own binary file, written on a background thread when the game saves.
+	// Opening only lists the folder, a save's files are mapped and decoded when it's loaded.
+	// The current save is resolved once per load into flags indexed by ingredient slot (see EligibilityIndex).
+	class KnownEffects
+	{
+	public:
+		// lists the records in a_directory, later saves and deletions are written there. a_onHeld reports writes that failed
+		void Open(const std::filesystem::path& a_directory, FileWriter::HeldCallback a_onHeld = {});
+		// imports the old single JSON file, renamed to .bak once converted by SetIngredients
+		void Migrate(const std::filesystem::path& a_legacyPath);
+		// slot -> key for the current load order. a_editorIDs (same order) converts the imported JSON records
+		void SetIngredients(std::span<const IngredientKey> a_keys, std::span<const std::string> a_editorIDs);
+		// blocks until queued record writes are on disk
+		void Flush();
+
+		void Load(const std::string& a_save);
+		void Save(const std::string& a_save);
+		void Delete(const std::string& a_save);
+
+		void                        Record(std::uint32_t a_slot, std::uint16_t a_knownEffectFlags) { currentFlags[a_slot] = a_knownEffectFlags; }
+		[[nodiscard]] std::uint16_t GetKnownEffectFlags(std::uint32_t a_slot) const { return currentFlags[a_slot]; }
+		[[nodiscard]] std::span<const std::uint16_t> GetKnownEffectFlags() const { return currentFlags; }
+
+		[[nodiscard]] std::size_t GetCurrentSize() const;
+		[[nodiscard]] std::size_t GetSaveCount() const { return saveParents.size() + legacySaveMaps.size(); }
+
+	private:
+		struct SaveRecord
+		{
+			std::uint64_t      parent{ 0 };  // snapshot hash
+			KnownEffectsRecord delta;        // applied over the snapshot, flags of 0 clear an entry
+		};
+
+		[[nodiscard]] std::filesystem::path        GetRecordPath(const std::string& a_save) const;
+		[[nodiscard]] std::filesystem::path        GetSnapshotPath(std::uint64_t a_hash) const;
+		[[nodiscard]] std::optional<std::uint32_t> FindSlot(std::uint32_t a_file, std::uint32_t a_localFormID) const;
+
+		[[nodiscard]] std::optional<SaveRecord>  ReadRecord(const std::string& a_save) const;
+		[[nodiscard]] const KnownEffectsRecord* GetSnapshot(std::uint64_t a_hash);
+		[[nodiscard]] std::uint64_t             GetParent(const std::string& a_save);
+
+		// applies a_record's entries in order to a_flags, entries from plugins that aren't loaded are appended to a_unresolved
+		void Resolve(const KnownEffectsRecord& a_record, std::vector<std::uint16_t>& a_flags, KnownEffectsRecord& a_unresolved) const;
+
+		std::uint64_t AddSnapshot(const KnownEffectsRecord& a_record);
+		void          ScanReferences();
+		void          Reference(std::uint64_t a_hash);
+		void          Release(std::uint64_t a_hash);
+
+		// members
+		std::filesystem::path                                      directory;
+		std::filesystem::path                                      legacyPath;
+		std::unordered_map<std::string, std::optional<std::uint64_t>> saveParents;     // every record, parent read on demand
+		std::unordered_map<std::string, SaveRecord>                savedRecords;    // written this session, may still be queued
+		std::unordered_map<std::uint64_t, KnownEffectsRecord>     snapshots;       // decoded on demand
+		std::unordered_map<std::uint64_t, std::uint32_t>          snapshotRefs;    // counted on first release
+		bool                                                       referencesScanned{ false };
+		std::unordered_map<std::string, IngredientKnownEffectsMap> legacySaveMaps;  // until SetIngredients converts them
+
+		std::vector<std::string>                         files;       // unique IngredientKey::file
+		std::vector<KnownEffectsEntry>                   slotKeys;    // slot -> files index + local FormID
+		std::unordered_map<std::uint64_t, std::uint32_t> slotLookup;  // files index << 32 | local FormID -> slot
+
+		// current save
+		std::uint64_t              parentHash{ 0 };
+		std::vector<std::uint16_t> parentFlags;       // slot -> snapshot flags
+		KnownEffectsRecord         parentUnresolved;  // snapshot entries from plugins that aren't loaded
+		std::vector<std::uint16_t> currentFlags;      // slot -> known effect flags
+		KnownEffectsRecord         unresolved;        // delta entries from plugins that aren't loaded, kept as is
+
+		std::unique_ptr<FileWriter> writer;  // null until opened, records then stay in memory
+	};
+
+	// Per slot mask ANDed into the ingredient's known effect flags. Clears the four effect bits, except the ones
+	// recorded as known for this save if a_keepKnownEffects. Bits above the effects are left as they are
+	void build_keep_masks(std::span<const std::uint16_t> a_knownEffectFlags, bool a_keepKnownEffects, std::span<std::uint16_t> a_keepMasks);
+}
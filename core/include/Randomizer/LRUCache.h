@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace Randomizer
+{
+	// Fixed-capacity map that drops the least recently used entry when full
+	template <class Key, class Value>
+	class LRUCache
+	{
+	public:
+		explicit LRUCache(std::size_t a_capacity = 1) :
+			capacity(std::max<std::size_t>(a_capacity, 1))
+		{}
+
+		// entry for a_key, default-constructed (evicting the oldest entry if needed) if missing
+		Value& operator[](const Key& a_key)
+		{
+			if (const auto it = lookup.find(a_key); it != lookup.end()) {
+				entries.splice(entries.begin(), entries, it->second);
+				return it->second->second;
+			}
+			Trim(capacity - 1);
+			entries.emplace_front(a_key, Value{});
+			lookup.emplace(a_key, entries.begin());
+			return entries.front().second;
+		}
+
+		Value* Find(const Key& a_key)
+		{
+			if (const auto it = lookup.find(a_key); it != lookup.end()) {
+				entries.splice(entries.begin(), entries, it->second);
+				return &it->second->second;
+			}
+			return nullptr;
+		}
+
+		void SetCapacity(std::size_t a_capacity)
+		{
+			capacity = std::max<std::size_t>(a_capacity, 1);
+			Trim(capacity);
+		}
+
+		[[nodiscard]] std::size_t GetCapacity() const { return capacity; }
+		[[nodiscard]] std::size_t size() const { return entries.size(); }
+
+	private:
+		void Trim(std::size_t a_size)
+		{
+			while (entries.size() > a_size) {
+				lookup.erase(entries.back().first);
+				entries.pop_back();
+			}
+		}
+
+		// members
+		std::list<std::pair<Key, Value>>                                         entries;  // most recently used first
+		std::unordered_map<Key, typename std::list<std::pair<Key, Value>>::iterator> lookup;
+		std::size_t                                                              capacity;
+	};
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace Randomizer
+{
+	// Read-only view of a whole file, empty if the file is missing or empty
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		explicit MappedFile(const std::filesystem::path& a_path);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile(MappedFile&& a_rhs) noexcept;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile& operator=(MappedFile&& a_rhs) noexcept;
+
+		[[nodiscard]] std::span<const std::byte> GetData() const { return data; }
+		[[nodiscard]] explicit operator bool() const { return !data.empty(); }
+
+	private:
+		void Close();
+
+		// members
+		std::span<const std::byte> data;
+#ifdef _WIN32
+		void* mapping{ nullptr };
+#endif
+	};
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Randomizer/ThreadPool.h"
+#include "Randomizer/Types.h"
+
+namespace Randomizer
+{
+	// Keyed bijection over [0, size). A Feistel network over the next power of two,
+	// cycle-walking values that fall outside the range. O(1) per index, no tables.
+	class FeistelPermutation
+	{
+	public:
+		static constexpr std::size_t rounds = 4;  // even, each half is updated rounds / 2 times
+
+		FeistelPermutation() = default;
+		FeistelPermutation(std::uint64_t a_seed, std::uint32_t a_size);
+
+		[[nodiscard]] std::uint32_t operator()(std::uint32_t a_index) const
+		{
+			auto index = Encrypt(a_index);
+			while (index >= size) {
+				index = Encrypt(index);
+			}
+			return index;
+		}
+
+		[[nodiscard]] std::uint32_t GetSize() const { return size; }
+
+	private:
+		[[nodiscard]] std::uint32_t Encrypt(std::uint32_t a_index) const;
+
+		// members
+		std::array<std::uint64_t, rounds> keys{};
+		std::uint32_t                     rightBits{ 0 };
+		std::uint32_t                     leftMask{ 0 };
+		std::uint32_t                     rightMask{ 0 };
+		std::uint32_t                     size{ 0 };
+	};
+
+	using SlotPatch = std::pair<std::uint32_t, EffectIndex>;  // effect slot -> effect, overrides the permutation
+
+	// kPermutation without a materialized table : slot i holds the original slot permutation(i),
+	// except for the slots the duplicate repair changed. Those are marked in a bitmap with per-word ranks
+	// into the patched effects, about 0.19 bytes per slot plus 2 bytes per patch against 2 bytes per materialized slot.
+	class KeyedShuffle
+	{
+	public:
+		KeyedShuffle() = default;
+		KeyedShuffle(std::uint64_t a_seed, std::size_t a_groupCount, std::vector<SlotPatch> a_patches = {});
+
+		[[nodiscard]] EffectIndex       GetEffect(const IngredientEffectGroups& a_original, std::size_t a_slot) const;
+		[[nodiscard]] IngredientEffects GetGroup(const IngredientEffectGroups& a_original, std::size_t a_group) const;
+
+		// every group, evaluated in parallel
+		void Materialize(const IngredientEffectGroups& a_original, IngredientEffectGroups& a_effectGroups, ThreadPool* a_pool = nullptr) const;
+
+		[[nodiscard]] std::uint64_t GetSeed() const { return seed; }
+		[[nodiscard]] std::size_t   GetPatchCount() const { return patchEffects.size(); }
+
+	private:
+		// members
+		std::uint64_t              seed{ 0 };
+		FeistelPermutation         permutation;
+		std::vector<std::uint64_t> patchedBits;   // by effect slot, empty without patches
+		std::vector<std::uint32_t> patchRanks;    // patches before each bitmap word
+		std::vector<EffectIndex>   patchEffects;  // by slot
+	};
+}
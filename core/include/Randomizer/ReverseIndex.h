@@ -0,0 +1,31 @@
+#pragma once
+
+#include <span>
+
+#include "Randomizer/EffectTable.h"
+#include "Randomizer/Types.h"
+
+namespace Randomizer
+{
+	// Base effect -> ingredient slots that carry it, as flat CSR arrays with each list sorted by slot.
+	// Shuffles only move effects between slots, so after an apply only the lists of the bases that moved are rewritten.
+	class ReverseIndex
+	{
+	public:
+		void Build(const EffectTable& a_table, const IngredientEffectGroups& a_effectGroups);
+		// a_groups : ingredient slots whose effects changed since the last build or update.
+		// Rebuilds if the number of ingredients carrying a base changed, returns false in that case
+		bool Update(const EffectTable& a_table, const IngredientEffectGroups& a_effectGroups, std::span<const std::uint32_t> a_groups);
+
+		[[nodiscard]] std::span<const std::uint32_t> GetIngredients(BaseIndex a_base) const { return std::span(slots).subspan(offsets[a_base], offsets[a_base + 1] - offsets[a_base]); }
+		[[nodiscard]] std::span<const std::uint32_t> GetOffsets() const { return offsets; }  // BaseIndex -> first entry, GetBaseCount() + 1 entries
+		[[nodiscard]] std::span<const std::uint32_t> GetSlots() const { return slots; }
+		[[nodiscard]] std::size_t                    GetBaseCount() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+	private:
+		// members
+		std::vector<std::uint32_t> offsets;
+		std::vector<std::uint32_t> slots;      // ingredient slots grouped by base
+		std::vector<BaseIndex>     slotBases;  // effect slot -> base it's listed under
+	};
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+
+#include "Randomizer/FileWriter.h"
+
+namespace Randomizer::serialize
+{
+	// little helpers for the binary files : trivially copyable values as raw bytes, strings as u16 length + chars
+
+	template <class T>
+	void put(Bytes& a_out, T a_value)
+	{
+		const auto bytes = std::bit_cast<std::array<std::byte, sizeof(T)>>(a_value);
+		a_out.insert(a_out.end(), bytes.begin(), bytes.end());
+	}
+
+	inline void put(Bytes& a_out, const std::string& a_string)
+	{
+		put(a_out, static_cast<std::uint16_t>(a_string.size()));
+		const auto chars = std::as_bytes(std::span(a_string));
+		a_out.insert(a_out.end(), chars.begin(), chars.end());
+	}
+
+	template <class T>
+	bool get(std::span<const std::byte>& a_in, T& a_value)
+	{
+		if (a_in.size() < sizeof(T)) {
+			return false;
+		}
+		std::memcpy(&a_value, a_in.data(), sizeof(T));
+		a_in = a_in.subspan(sizeof(T));
+		return true;
+	}
+
+	inline bool get(std::span<const std::byte>& a_in, std::string& a_string)
+	{
+		std::uint16_t length = 0;
+		if (!get(a_in, length) || a_in.size() < length) {
+			return false;
+		}
+		a_string.assign(reinterpret_cast<const char*>(a_in.data()), length);
+		a_in = a_in.subspan(length);
+		return true;
+	}
+
+	// FNV-1a, never 0 so callers can use it as "none"
+	inline std::uint64_t hash_bytes(std::span<const std::byte> a_data, std::uint64_t a_hash = 0xCBF29CE484222325)
+	{
+		for (const auto byte : a_data) {
+			a_hash = (a_hash ^ std::to_integer<std::uint64_t>(byte)) * 0x100000001B3;
+		}
+		return a_hash != 0 ? a_hash : 1;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Randomizer/EffectTable.h"
+#include "Randomizer/Permutation.h"
+#include "Randomizer/ThreadPool.h"
+#include "Randomizer/Types.h"
+
+namespace Randomizer
+{
+	// bump whenever shuffle_effect_groups or make_keyed_shuffle return something else for the same input, invalidates cached results
+	inline constexpr std::uint32_t shuffleVersion = 1;
+
+	// kConstrained : bounds on how many ingredients carry each base effect
+	struct ShuffleConstraints
+	{
+		std::uint32_t minPerBase{ 2 };  // an effect on a single ingredient can't be crafted
+		std::uint32_t maxPerBase{ 0 };  // 0 : only limited by the ingredient count
+	};
+
+	struct ShuffleResult
+	{
+		enum class STATUS
+		{
+			kSuccess,
+			kImpossible,     // a base effect occupies more slots than there are ingredients, duplicates are unavoidable
+			kUnsatisfiable   // kConstrained : the base effects can't fill every slot within the constraints
+		};
+
+		STATUS                     status{ STATUS::kSuccess };
+		std::uint32_t              repairs{ 0 };           // duplicate slots fixed by swapping with another ingredient
+		std::uint32_t              partitions{ 0 };        // kShuffle, kPermutation : independently repaired partitions
+		std::uint32_t              failedPartitions{ 0 };  // kShuffle, kPermutation : partitions that ran out of repair budget
+		std::vector<std::uint32_t> partitionRepairs;       // kShuffle, kPermutation : repairs per partition
+		bool                       constructed{ false };   // repair budget ran out and the constructive layout was used
+		BaseEffectID               overflowBase{ 0 };      // kImpossible : most frequent base effect
+		std::size_t                overflowCount{ 0 };     // kImpossible : number of slots it occupies
+		std::uint32_t              rebalanced{ 0 };        // kConstrained : slots moved to another base effect
+		std::size_t                baseCount{ 0 };         // kConstrained : base effects in play
+		std::size_t                boundSlots{ 0 };        // kUnsatisfiable : slots the constraints allow (max) or require (min)
+		std::size_t                patches{ 0 };           // make_keyed_shuffle : slots stored next to the seed
+		std::size_t                groupCount{ 0 };
+
+		[[nodiscard]] bool success() const { return status == STATUS::kSuccess; }
+	};
+
+	// true if no effect group contains the same base effect twice
+	[[nodiscard]] bool is_distribution_unique(const EffectTable& a_table, const IngredientEffectGroups& a_effectGroups);
+
+	// kShuffle and kPermutation expect four effects per group. If a duplicate-free distribution is impossible, a_effectGroups is left untouched.
+	// kConstrained may change how often each effect occurs, hosts have to supply extra instances (see EffectInstances::GetShortfall).
+	// The result only depends on a_seed and a_effectGroups, not on the number of cores. Without a pool, everything runs on the calling thread.
+	ShuffleResult shuffle_effect_groups(std::uint64_t a_seed, SHUFFLE_METHOD a_method, const EffectTable& a_table, IngredientEffectGroups& a_effectGroups, ThreadPool* a_pool = nullptr, const ShuffleConstraints& a_constraints = {});
+
+	// kPermutation, keeping only the seed and the slots the repair changed. Groups resolve against a_original on demand.
+	// If the result isn't a success, the keyed shuffle has no patches and must not be applied.
+	KeyedShuffle make_keyed_shuffle(std::uint64_t a_seed, const EffectTable& a_table, const IngredientEffectGroups& a_original, ThreadPool* a_pool, ShuffleResult& a_result);
+
+	using SlotSwap = std::pair<std::uint32_t, std::uint32_t>;
+
+	// Partial reshuffle : every slot of a_groups is swapped with a random slot elsewhere, as long as both groups stay duplicate-free.
+	// Returns the swaps in the order they were made, so hosts can move their effect objects the same way. Effect counts never change.
+	std::vector<SlotSwap> reshuffle_effect_groups(std::uint64_t a_seed, const EffectTable& a_table, IngredientEffectGroups& a_effectGroups, std::span<const std::uint32_t> a_groups);
+}
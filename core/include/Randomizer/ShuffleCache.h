@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+#include "Randomizer/EffectTable.h"
+#include "Randomizer/KnownEffects.h"
+#include "Randomizer/Shuffle.h"
+#include "Randomizer/Types.h"
+
+namespace Randomizer
+{
+	// everything a shuffle's output depends on : algorithm version, seed, method, constraints (kConstrained),
+	// the eligible ingredients in slot order and their effects. Never 0.
+	// Condition handles are host addresses, only their presence is hashed, the groups already tell conditioned effects apart.
+	[[nodiscard]] std::uint64_t hash_shuffle_input(std::uint64_t a_seed, SHUFFLE_METHOD a_method, const ShuffleConstraints& a_constraints, const EffectTable& a_table, const IngredientEffectGroups& a_original, std::span<const IngredientKey> a_ingredients);
+
+	// the final effect groups of a previous run, nullopt if the file is missing, damaged or was written for other inputs
+	[[nodiscard]] std::optional<IngredientEffectGroups> read_shuffle_cache(const std::filesystem::path& a_path, std::uint64_t a_key, const EffectTable& a_table);
+	bool                                                write_shuffle_cache(const std::filesystem::path& a_path, std::uint64_t a_key, const IngredientEffectGroups& a_effectGroups);
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Randomizer
+{
+	// Epoch-based reclamation. Readers pin the current epoch while they dereference shared memory,
+	// memory retired by a writer is freed once every reader pinned at or before the epoch it was retired in has left.
+	// Pinning never waits on writers, writers only serialize among themselves to free memory.
+	class EpochDomain
+	{
+	public:
+		static constexpr std::size_t maxReaders = 64;  // concurrent pins, further readers retry until one leaves
+
+		using Deleter = void (*)(void*);
+
+		class Pin
+		{
+		public:
+			Pin(const Pin&) = delete;
+			Pin(Pin&&) = delete;
+			Pin& operator=(const Pin&) = delete;
+			Pin& operator=(Pin&&) = delete;
+
+			~Pin() { epoch.store(0, std::memory_order_release); }
+
+		private:
+			friend EpochDomain;
+
+			explicit Pin(std::atomic<std::uint64_t>& a_epoch) :
+				epoch(a_epoch)
+			{}
+
+			// members
+			std::atomic<std::uint64_t>& epoch;
+		};
+
+		EpochDomain() = default;
+		~EpochDomain();
+
+		EpochDomain(const EpochDomain&) = delete;
+		EpochDomain(EpochDomain&&) = delete;
+		EpochDomain& operator=(const EpochDomain&) = delete;
+		EpochDomain& operator=(EpochDomain&&) = delete;
+
+		[[nodiscard]] Pin Enter();
+		// a_delete(a_ptr) runs once no reader can still see a_ptr, at the latest when the domain is destroyed
+		void Retire(void* a_ptr, Deleter a_delete);
+
+	private:
+		struct alignas(64) Slot
+		{
+			std::atomic<std::uint64_t> epoch{ 0 };  // 0 : free
+		};
+
+		struct Retired
+		{
+			void*         ptr;
+			Deleter       destroy;
+			std::uint64_t epoch;
+		};
+
+		void Collect();
+
+		// members
+		std::atomic<std::uint64_t>   epoch{ 1 };
+		std::array<Slot, maxReaders> slots{};
+		std::mutex                   retiredLock;
+		std::vector<Retired>         retired;
+	};
+
+	// Current value of T, held as an immutable reference counted snapshot.
+	// Load() never takes a lock, Store() swaps the new snapshot in and retires the old one.
+	// Readers keep the snapshot they loaded for as long as they need it, newer stores don't affect it.
+	template <class T>
+	class Published
+	{
+	public:
+		using Snapshot = std::shared_ptr<const T>;
+
+		Published() = default;
+		~Published() { delete current.load(); }
+
+		Published(const Published&) = delete;
+		Published(Published&&) = delete;
+		Published& operator=(const Published&) = delete;
+		Published& operator=(Published&&) = delete;
+
+		// null until the first store
+		[[nodiscard]] Snapshot Load() const
+		{
+			const auto pin = epochs.Enter();
+			const auto node = current.load();
+			return node ? node->snapshot : nullptr;
+		}
+
+		void Store(Snapshot a_snapshot)
+		{
+			const auto node = a_snapshot ? new Node{ std::move(a_snapshot) } : nullptr;
+			if (const auto old = current.exchange(node)) {
+				epochs.Retire(old, [](void* a_node) { delete static_cast<Node*>(a_node); });
+			}
+		}
+
+		void Store(T a_value) { Store(std::make_shared<const T>(std::move(a_value))); }
+
+	private:
+		struct Node
+		{
+			Snapshot snapshot;
+		};
+
+		// members
+		std::atomic<Node*>  current{ nullptr };
+		mutable EpochDomain epochs;
+	};
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Randomizer/Shuffle.h"
+
+namespace Randomizer
+{
+	struct PhaseStats
+	{
+		std::uint64_t calls{ 0 };
+		double        totalMs{ 0.0 };
+		double        maxMs{ 0.0 };
+		double        lastMs{ 0.0 };
+	};
+
+	struct ShuffleStats
+	{
+		std::uint64_t              seed{ 0 };
+		std::string                method;
+		std::size_t                groups{ 0 };
+		double                     ms{ 0.0 };
+		std::uint32_t              repairs{ 0 };
+		std::uint32_t              partitions{ 0 };
+		std::uint32_t              failedPartitions{ 0 };
+		std::vector<std::uint32_t> partitionRepairs;
+		std::uint32_t              rebalanced{ 0 };
+		std::size_t                patches{ 0 };
+		bool                       constructed{ false };
+		bool                       impossible{ false };
+	};
+
+	struct StatsData
+	{
+		std::string                          version;
+		std::map<std::string, PhaseStats>    phases;
+		std::map<std::string, std::uint64_t> counters;
+		std::vector<ShuffleStats>            shuffles;  // most recent last
+	};
+
+	// Per-session timings and counters. Thread safe, shuffles may be recorded from pool threads.
+	class Stats
+	{
+	public:
+		class ScopedTimer
+		{
+		public:
+			ScopedTimer(Stats& a_stats, std::string_view a_phase) :
+				stats(a_stats),
+				phase(a_phase)
+			{}
+			~ScopedTimer() { stats.AddTime(phase, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()); }
+
+			ScopedTimer(const ScopedTimer&) = delete;
+			ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+		private:
+			// members
+			Stats&                                stats;
+			std::string_view                      phase;
+			std::chrono::steady_clock::time_point start{ std::chrono::steady_clock::now() };
+		};
+
+		static constexpr std::size_t maxShuffles = 32;
+
+		[[nodiscard]] ScopedTimer Time(std::string_view a_phase) { return { *this, a_phase }; }
+
+		void SetVersion(std::string_view a_version);
+		void AddTime(std::string_view a_phase, double a_ms);
+		void AddCount(std::string_view a_counter, std::uint64_t a_value = 1);
+		void SetCount(std::string_view a_counter, std::uint64_t a_value);
+		void AddShuffle(std::uint64_t a_seed, SHUFFLE_METHOD a_method, double a_ms, const ShuffleResult& a_result);
+
+		[[nodiscard]] StatsData GetData() const;
+		// "phase : calls | total | max" lines for the log
+		[[nodiscard]] std::vector<std::string> GetSummary() const;
+		void                                   Write(const std::filesystem::path& a_path) const;
+
+	private:
+		// members
+		mutable std::mutex lock;
+		StatsData          data;
+	};
+}
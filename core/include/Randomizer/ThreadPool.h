@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Randomizer
+{
+	// Long-lived work-stealing pool. Each worker owns a deque, runs its own tasks newest-first and steals the oldest
+	// from the others when empty. Idle workers sleep on a condition variable.
+	class ThreadPool
+	{
+	public:
+		explicit ThreadPool(std::size_t a_threadCount);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(ThreadPool&&) = delete;
+
+		template <class F>
+		auto Submit(F&& a_func) -> std::future<std::invoke_result_t<F>>
+		{
+			auto task = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(a_func));
+			auto future = task->get_future();
+			Push([task]() { (*task)(); });
+			return future;
+		}
+
+		// runs a_func(0 .. a_count - 1) across the pool and the calling thread, returns once every index is done
+		void ParallelFor(std::size_t a_count, const std::function<void(std::size_t)>& a_func);
+
+		[[nodiscard]] std::size_t GetThreadCount() const { return threads.size(); }
+
+	private:
+		using Task = std::function<void()>;
+
+		struct Queue
+		{
+			std::mutex       lock;
+			std::deque<Task> tasks;
+		};
+
+		void Push(Task a_task);
+		bool TryPop(std::size_t a_index, Task& a_task);
+		bool PopFrom(std::size_t a_index, Task& a_task);
+		void WorkerLoop(std::stop_token a_stop, std::size_t a_index);
+
+		// members
+		std::vector<std::unique_ptr<Queue>> queues;
+		std::vector<std::jthread>           threads;
+		std::atomic<std::size_t>            nextQueue{ 0 };
+		std::size_t                         pending{ 0 };  // queued tasks, guarded by idleLock
+		std::mutex                          idleLock;
+		std::condition_variable_any         idle;
+	};
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Randomizer
+{
+	enum class SHUFFLE_METHOD
+	{
+		kSwap,
+		kShuffle,
+		kConstrained,  // kShuffle, after rebalancing how many ingredients carry each base effect
+		kPermutation   // keyed permutation of every slot, stored as the seed plus the slots the duplicate repair changed
+	};
+
+	using BaseEffectID = std::uint32_t;  // host identity of a base effect (EffectSetting)
+	using EffectIndex = std::uint16_t;   // interned effect, see EffectTable
+	using BaseIndex = std::uint16_t;     // interned base effect, used for uniqueness
+	using InstanceID = std::uint32_t;    // host effect object, numbered by effect slot in the unshuffled load order
+
+	using IngredientEffects = std::array<EffectIndex, 4>;
+	using IngredientEffectGroups = std::vector<IngredientEffects>;  // contiguous, four slots per ingredient
+
+	inline EffectIndex& get_slot(IngredientEffectGroups& a_effectGroups, std::size_t a_slot) { return a_effectGroups[a_slot / 4][a_slot % 4]; }
+	inline EffectIndex  get_slot(const IngredientEffectGroups& a_effectGroups, std::size_t a_slot) { return a_effectGroups[a_slot / 4][a_slot % 4]; }
+}
@@ -0,0 +1,102 @@
+#include "Randomizer/Apply.h"
+
+namespace Randomizer
+{
+	AppliedEffects::AppliedEffects(const IngredientEffectGroups& a_original) :
+		effectGroups(a_original),
+		instances(a_original.size())
+	{
+		for (std::uint32_t slot = 0; slot < instances.size(); ++slot) {
+			instances[slot] = { slot * 4, slot * 4 + 1, slot * 4 + 2, slot * 4 + 3 };
+		}
+	}
+
+	void AppliedEffects::Swap(std::uint32_t a_effectSlot, std::uint32_t a_partnerSlot)
+	{
+		std::swap(get_slot(effectGroups, a_effectSlot), get_slot(effectGroups, a_partnerSlot));
+		std::swap(instances[a_effectSlot / 4][a_effectSlot % 4], instances[a_partnerSlot / 4][a_partnerSlot % 4]);
+	}
+
+	std::vector<std::uint32_t> AppliedEffects::Update(const IngredientEffectGroups& a_effectGroups, const EffectInstances& a_instances)
+	{
+		std::vector<std::uint32_t> changed;
+
+		// different ingredients, nothing carries over
+		if (a_effectGroups.size() != effectGroups.size()) {
+			effectGroups = a_effectGroups;
+			instances.resize(effectGroups.size());
+			changed.resize(effectGroups.size());
+			std::iota(changed.begin(), changed.end(), 0);
+
+			EffectInstances::Cursor cursor(a_instances);
+			for (std::size_t slot = 0; slot < effectGroups.size(); ++slot) {
+				for (std::size_t i = 0; i < 4; ++i) {
+					instances[slot][i] = cursor(effectGroups[slot][i]);
+				}
+			}
+			return changed;
+		}
+
+		for (std::uint32_t slot = 0; slot < effectGroups.size(); ++slot) {
+			if (effectGroups[slot] != a_effectGroups[slot]) {
+				changed.push_back(slot);
+			}
+		}
+		if (changed.empty()) {
+			return changed;
+		}
+
+		// objects of changed effect slots go back to their effect's free list
+		std::vector<std::uint8_t>            used(a_instances.size(), false);
+		std::vector<std::vector<InstanceID>> freed(a_instances.GetEffectCount());
+		for (const auto& slotInstances : instances) {
+			for (const auto instance : slotInstances) {
+				used[instance] = true;
+			}
+		}
+		for (const auto slot : changed) {
+			for (std::size_t i = 0; i < 4; ++i) {
+				if (effectGroups[slot][i] != a_effectGroups[slot][i]) {
+					freed[effectGroups[slot][i]].push_back(instances[slot][i]);
+				}
+			}
+		}
+
+		// then handed to changed slots of the same effect, falling back to objects no slot holds (copies made for a shortfall)
+		std::vector<std::uint32_t> nextUnused(a_instances.GetEffectCount(), 0);
+		const auto                 take = [&](EffectIndex a_effect) -> std::optional<InstanceID> {
+			if (auto& list = freed[a_effect]; !list.empty()) {
+				const auto instance = list.back();
+				list.pop_back();
+				return instance;
+			}
+			const auto candidates = a_instances.GetInstances(a_effect);
+			for (auto& next = nextUnused[a_effect]; next < candidates.size(); ++next) {
+				if (const auto instance = candidates[next]; !used[instance]) {
+					used[instance] = true;
+					return instance;
+				}
+			}
+			return std::nullopt;
+		};
+
+		for (const auto slot : changed) {
+			for (std::size_t i = 0; i < 4; ++i) {
+				const auto effect = a_effectGroups[slot][i];
+				if (effectGroups[slot][i] == effect) {
+					continue;
+				}
+				if (const auto instance = take(effect)) {
+					instances[slot][i] = *instance;
+				} else {
+					// more slots of this effect than objects, only if the host skipped the shortfall. Redo everything
+					effectGroups.clear();
+					return Update(a_effectGroups, a_instances);
+				}
+			}
+			effectGroups[slot] = a_effectGroups[slot];
+		}
+
+		return changed;
+	}
+}
@@ -0,0 +1,165 @@
+#include "Randomizer/Blacklist.h"
+#include "Randomizer/MappedFile.h"
+#include "Randomizer/Serialize.h"
+
+#include <cctype>
+
+namespace Randomizer
+{
+	namespace
+	{
+		using namespace serialize;
+
+		// magic + version, config hash, then editorIDs, prefixes and plugins, each a u32 count + [u16 length, chars] per rule
+		constexpr std::uint32_t fileMagic = 'A' | 'E' << 8 | 'R' << 16 | 'B' << 24;
+		constexpr std::uint32_t fileVersion = 2;
+
+		std::string to_lower(std::string_view a_str)
+		{
+			std::string str(a_str);
+			std::ranges::transform(str, str.begin(), [](unsigned char a_ch) { return static_cast<char>(std::tolower(a_ch)); });
+			return str;
+		}
+
+		bool is_plugin(std::string_view a_entry)
+		{
+			if (a_entry.size() < 4) {
+				return false;
+			}
+			const auto extension = to_lower(a_entry.substr(a_entry.size() - 4));
+			return extension == ".esp" || extension == ".esm" || extension == ".esl";
+		}
+
+		void put_strings(Bytes& a_out, const std::vector<std::string>& a_strings)
+		{
+			put(a_out, static_cast<std::uint32_t>(a_strings.size()));
+			for (const auto& str : a_strings) {
+				put(a_out, str);
+			}
+		}
+
+		bool get_strings(std::span<const std::byte>& a_in, std::vector<std::string>& a_strings)
+		{
+			std::uint32_t count = 0;
+			if (!get(a_in, count)) {
+				return false;
+			}
+			a_strings.resize(count);
+			return std::ranges::all_of(a_strings, [&](std::string& a_str) { return get(a_in, a_str); });
+		}
+
+		std::uint64_t hash_string(std::string_view a_str, std::uint64_t a_hash)
+		{
+			// length first, so ("ab", "c") and ("a", "bc") differ
+			const auto length = static_cast<std::uint64_t>(a_str.size());
+			a_hash = hash_bytes(std::as_bytes(std::span(&length, 1)), a_hash);
+			return hash_bytes(std::as_bytes(std::span(a_str)), a_hash);
+		}
+	}
+
+	void BlacklistRules::Add(std::string_view a_entry)
+	{
+		if (a_entry.empty()) {
+			return;
+		}
+		if (a_entry.back() == '*') {
+			a_entry.remove_suffix(1);
+			if (!a_entry.empty()) {
+				prefixes.push_back(to_lower(a_entry));
+			}
+		} else if (is_plugin(a_entry)) {
+			plugins.push_back(to_lower(a_entry));
+		} else {
+			editorIDs.push_back(to_lower(a_entry));
+		}
+	}
+
+	void BlacklistRules::Merge(const BlacklistRules& a_rules)
+	{
+		editorIDs.insert(editorIDs.end(), a_rules.editorIDs.begin(), a_rules.editorIDs.end());
+		prefixes.insert(prefixes.end(), a_rules.prefixes.begin(), a_rules.prefixes.end());
+		plugins.insert(plugins.end(), a_rules.plugins.begin(), a_rules.plugins.end());
+	}
+
+	BlacklistMatcher::BlacklistMatcher(const BlacklistRules& a_rules) :
+		editorIDs(a_rules.editorIDs.begin(), a_rules.editorIDs.end()),
+		plugins(a_rules.plugins.begin(), a_rules.plugins.end())
+	{
+		// sorted, a prefix is dropped if it starts with the one kept before it
+		auto sorted = a_rules.prefixes;
+		std::ranges::sort(sorted);
+		for (auto& prefix : sorted) {
+			if (prefixes.empty() || !prefix.starts_with(prefixes.back())) {
+				prefixes.push_back(std::move(prefix));
+			}
+		}
+	}
+
+	std::optional<BlacklistMatch> BlacklistMatcher::Match(std::string_view a_file, std::string_view a_editorID) const
+	{
+		if (!plugins.empty()) {
+			if (const auto it = plugins.find(to_lower(a_file)); it != plugins.end()) {
+				return BlacklistMatch{ BlacklistRules::RULE::kPlugin, *it };
+			}
+		}
+		if (editorIDs.empty() && prefixes.empty()) {
+			return std::nullopt;
+		}
+
+		const auto editorID = to_lower(a_editorID);
+		if (const auto it = editorIDs.find(editorID); it != editorIDs.end()) {
+			return BlacklistMatch{ BlacklistRules::RULE::kEditorID, *it };
+		}
+		// no kept prefix starts with another, so any prefix of editorID is the last one sorting before it
+		if (const auto it = std::ranges::upper_bound(prefixes, editorID); it != prefixes.begin() && editorID.starts_with(*std::prev(it))) {
+			return BlacklistMatch{ BlacklistRules::RULE::kPrefix, *std::prev(it) };
+		}
+		return std::nullopt;
+	}
+
+	std::uint64_t hash_configs(std::span<const std::string> a_paths)
+	{
+		std::uint64_t hash = hash_bytes({});
+		for (const auto& path : a_paths) {
+			std::error_code ec;
+			const auto      size = static_cast<std::uint64_t>(std::filesystem::file_size(path, ec));
+			const auto      time = static_cast<std::int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+			hash = hash_string(path, hash);
+			hash = hash_bytes(std::as_bytes(std::span(&size, 1)), hash);
+			hash = hash_bytes(std::as_bytes(std::span(&time, 1)), hash);
+		}
+		return hash;
+	}
+
+	std::optional<BlacklistCache> read_blacklist_cache(const std::filesystem::path& a_path)
+	{
+		const MappedFile file(a_path);
+		if (!file) {
+			return std::nullopt;
+		}
+
+		auto           in = file.GetData();
+		std::uint32_t  magic = 0, version = 0;
+		BlacklistCache cache;
+		if (!get(in, magic) || magic != fileMagic || !get(in, version) || version != fileVersion ||
+			!get(in, cache.configHash) || !get_strings(in, cache.rules.editorIDs) || !get_strings(in, cache.rules.prefixes) || !get_strings(in, cache.rules.plugins)) {
+			return std::nullopt;
+		}
+		return cache;
+	}
+
+	bool write_blacklist_cache(const std::filesystem::path& a_path, const BlacklistCache& a_cache)
+	{
+		Bytes out;
+		put(out, fileMagic);
+		put(out, fileVersion);
+		put(out, a_cache.configHash);
+		put_strings(out, a_cache.rules.editorIDs);
+		put_strings(out, a_cache.rules.prefixes);
+		put_strings(out, a_cache.rules.plugins);
+
+		std::error_code ec;
+		std::filesystem::create_directories(a_path.parent_path(), ec);
+		return write_file_atomic(a_path, out);
+	}
+}
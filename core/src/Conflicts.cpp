@@ -0,0 +1,22 @@
+#include "Randomizer/Conflicts.h"
+
+namespace Randomizer
+{
+	ConflictIndex::ConflictIndex(std::span<const IngredientEffects> a_effectGroups, std::span<const BaseIndex> a_bases) :
+		effectGroups(a_effectGroups),
+		bases(a_bases),
+		conflicted(a_effectGroups.size(), 0)
+	{
+		for (std::size_t i = 0; i < effectGroups.size(); ++i) {
+			conflicted[i] = has_duplicate_base(effectGroups[i], bases);
+			count += conflicted[i];
+		}
+	}
+
+	void ConflictIndex::Update(std::size_t a_group)
+	{
+		const std::uint8_t now = has_duplicate_base(effectGroups[a_group], bases);
+		count = count - conflicted[a_group] + now;
+		conflicted[a_group] = now;
+	}
+}
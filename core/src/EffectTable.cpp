@@ -0,0 +1,100 @@
+#include "Randomizer/EffectTable.h"
+
+namespace Randomizer
+{
+	std::size_t EffectTable::Hash::operator()(const EffectData& a_effect) const
+	{
+		std::size_t seed = std::hash<BaseEffectID>{}(a_effect.base);
+		const auto  combine = [&](std::size_t a_value) {
+			seed ^= a_value + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2);
+		};
+		combine(std::bit_cast<std::uint32_t>(a_effect.magnitude));
+		combine(a_effect.area);
+		combine(a_effect.duration);
+		combine(a_effect.conditions);
+		return seed;
+	}
+
+	std::optional<EffectIndex> EffectTable::Intern(const EffectData& a_effect)
+	{
+		if (const auto it = effectLookup.find(a_effect); it != effectLookup.end()) {
+			return it->second;
+		}
+		if (effects.size() >= maxSize) {
+			return std::nullopt;
+		}
+
+		// base effects never outnumber effects, so they fit too
+		const auto [baseIt, newBase] = baseLookup.try_emplace(a_effect.base, static_cast<BaseIndex>(baseIDs.size()));
+		if (newBase) {
+			baseIDs.push_back(a_effect.base);
+		}
+
+		const auto index = static_cast<EffectIndex>(effects.size());
+		effects.push_back(a_effect);
+		bases.push_back(baseIt->second);
+		effectLookup.emplace(a_effect, index);
+
+		return index;
+	}
+
+	EffectInstances::EffectInstances(const IngredientEffectGroups& a_original, std::size_t a_effectCount) :
+		offsets(a_effectCount + 1, 0),
+		instances(a_original.size() * 4)
+	{
+		for (const auto& effectGroup : a_original) {
+			for (const auto& effect : effectGroup) {
+				offsets[effect + 1]++;
+			}
+		}
+		std::inclusive_scan(offsets.begin(), offsets.end(), offsets.begin());
+
+		auto next = offsets;
+		for (std::size_t slot = 0; slot < instances.size(); ++slot) {
+			instances[next[get_slot(a_original, slot)]++] = static_cast<InstanceID>(slot);
+		}
+	}
+
+	std::vector<std::pair<EffectIndex, std::uint32_t>> EffectInstances::GetShortfall(const IngredientEffectGroups& a_effectGroups) const
+	{
+		std::vector<std::uint32_t> demand(offsets.size() - 1, 0);
+		for (const auto& effectGroup : a_effectGroups) {
+			for (const auto& effect : effectGroup) {
+				demand[effect]++;
+			}
+		}
+
+		std::vector<std::pair<EffectIndex, std::uint32_t>> shortfall;
+		for (std::size_t effect = 0; effect < demand.size(); ++effect) {
+			if (const auto available = offsets[effect + 1] - offsets[effect]; demand[effect] > available) {
+				shortfall.emplace_back(static_cast<EffectIndex>(effect), demand[effect] - available);
+			}
+		}
+		return shortfall;
+	}
+
+	void EffectInstances::Add(std::span<const std::pair<EffectIndex, InstanceID>> a_instances)
+	{
+		std::vector<std::uint32_t> added(offsets.size(), 0);
+		for (const auto& effect : a_instances | std::views::keys) {
+			added[effect + 1]++;
+		}
+		std::inclusive_scan(added.begin(), added.end(), added.begin());
+
+		// existing runs move up by the number of instances added before them
+		std::vector<InstanceID>    merged(instances.size() + a_instances.size());
+		std::vector<std::uint32_t> next(offsets.size() - 1);
+		for (std::size_t effect = 0; effect + 1 < offsets.size(); ++effect) {
+			const auto begin = offsets[effect] + added[effect];
+			std::copy(instances.begin() + offsets[effect], instances.begin() + offsets[effect + 1], merged.begin() + begin);
+			next[effect] = begin + (offsets[effect + 1] - offsets[effect]);
+		}
+		for (const auto& [effect, instance] : a_instances) {
+			merged[next[effect]++] = instance;
+		}
+		for (std::size_t i = 0; i < offsets.size(); ++i) {
+			offsets[i] += added[i];
+		}
+		instances = std::move(merged);
+	}
+}
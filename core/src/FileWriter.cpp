@@ -0,0 +1,168 @@
+#include "Randomizer/FileWriter.h"
+
+namespace Randomizer
+{
+	bool write_file_atomic(const std::filesystem::path& a_path, std::span<const std::byte> a_data)
+	{
+		auto tempPath = a_path;
+		tempPath += ".tmp";
+
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file.write(reinterpret_cast<const char*>(a_data.data()), static_cast<std::streamsize>(a_data.size())) || !file.flush()) {
+				return false;
+			}
+		}
+
+		std::error_code ec;
+		std::filesystem::rename(tempPath, a_path, ec);  // replaces the existing file
+		if (ec) {
+			std::filesystem::remove(tempPath, ec);
+			return false;
+		}
+		return true;
+	}
+
+	FileWriter::FileWriter(HeldCallback a_onHeld) :
+		onHeld(std::move(a_onHeld)),
+		thread([this](std::stop_token a_stop) { WriterLoop(a_stop); })
+	{}
+
+	FileWriter::~FileWriter()
+	{
+		thread.request_stop();
+		wake.notify_all();
+	}
+
+	void FileWriter::Write(std::filesystem::path a_path, Bytes a_data, std::filesystem::path a_dependency)
+	{
+		Queue({ std::move(a_path), std::move(a_data), std::move(a_dependency) });
+	}
+
+	void FileWriter::Remove(std::filesystem::path a_path)
+	{
+		Queue({ std::move(a_path), std::nullopt, {} });
+	}
+
+	void FileWriter::Queue(Job a_job)
+	{
+		{
+			std::scoped_lock guard(lock);
+			if (const auto it = std::ranges::find(jobs, a_job.path, &Job::path); it != jobs.end()) {
+				jobs.erase(it);
+			}
+			jobs.push_back(std::move(a_job));
+		}
+		wake.notify_one();
+	}
+
+	void FileWriter::Flush()
+	{
+		std::unique_lock guard(lock);
+		drained.wait(guard, [this] { return jobs.empty() && !busy; });
+	}
+
+	std::vector<FileWriter::Job> FileWriter::run_jobs(std::vector<Job> a_jobs)
+	{
+		// a path is pending until its job succeeds, failed ones stay pending so their dependants wait too
+		std::set<std::filesystem::path> pending;
+		for (const auto& job : a_jobs) {
+			pending.insert(job.path);
+		}
+
+		enum class STATE : std::uint8_t
+		{
+			kWaiting,
+			kDone,
+			kFailed  // one attempt per batch
+		};
+
+		std::vector<STATE> states(a_jobs.size(), STATE::kWaiting);
+		for (bool progress = true; progress;) {
+			progress = false;
+			for (std::size_t i = 0; i < a_jobs.size(); ++i) {
+				const auto& [path, data, dependency] = a_jobs[i];
+				if (states[i] != STATE::kWaiting || (!dependency.empty() && pending.contains(dependency))) {
+					continue;
+				}
+
+				bool written = true;
+				if (data) {
+					written = write_file_atomic(path, *data);
+				} else {
+					std::error_code ec;
+					std::filesystem::remove(path, ec);
+				}
+				if (written) {
+					states[i] = STATE::kDone;
+					pending.erase(path);
+					progress = true;
+				} else {
+					states[i] = STATE::kFailed;
+				}
+			}
+		}
+
+		std::vector<Job> remaining;
+		for (std::size_t i = 0; i < a_jobs.size(); ++i) {
+			if (states[i] != STATE::kDone) {
+				remaining.push_back(std::move(a_jobs[i]));
+			}
+		}
+		return remaining;
+	}
+
+	void FileWriter::WriterLoop(std::stop_token a_stop)
+	{
+		std::vector<Job>                batch;
+		std::vector<Job>                held;  // failed, or waiting on a failed dependency
+		std::set<std::filesystem::path> reported;
+		auto                            retryDelay = minRetryDelay;
+		while (true) {
+			{
+				std::unique_lock guard(lock);
+				busy = false;
+				drained.notify_all();
+				const auto has_jobs = [this] { return !jobs.empty(); };
+				if (held.empty()) {
+					wake.wait(guard, a_stop, has_jobs);
+				} else if (!wake.wait_for(guard, a_stop, retryDelay, has_jobs)) {
+					retryDelay = std::min(retryDelay * 2, maxRetryDelay);  // nothing new, retry the held jobs alone
+				}
+				if (jobs.empty() && held.empty()) {
+					return;  // stop requested and nothing left to write
+				}
+				// held jobs go first, unless a newer request for the same path replaced them
+				std::erase_if(held, [this](const Job& a_job) { return std::ranges::find(jobs, a_job.path, &Job::path) != jobs.end(); });
+				batch = std::move(held);
+				std::ranges::move(jobs, std::back_inserter(batch));
+				jobs.clear();
+				busy = true;
+			}
+
+			held = run_jobs(std::move(batch));
+			batch.clear();
+			if (a_stop.stop_requested() && !held.empty()) {
+				held = run_jobs(std::move(held));  // last attempt before the writer goes away
+				if (onHeld) {
+					for (const auto& job : held) {
+						onHeld(job.path, true);
+					}
+				}
+				held.clear();
+			}
+
+			if (held.empty()) {
+				retryDelay = minRetryDelay;
+			}
+			std::set<std::filesystem::path> heldPaths;
+			for (const auto& job : held) {
+				if (onHeld && !reported.contains(job.path)) {
+					onHeld(job.path, false);
+				}
+				heldPaths.insert(job.path);
+			}
+			reported = std::move(heldPaths);
+		}
+	}
+}
@@ -0,0 +1,149 @@
+#include "Randomizer/IngredientDump.h"
+#include "Randomizer/MappedFile.h"
+#include "Randomizer/Serialize.h"
+
+namespace Randomizer
+{
+	namespace
+	{
+		using namespace serialize;
+
+		// magic + version
+		// ingredient count, [u16 length, file, u32 local FormID, u16 length, EDID] per ingredient
+		// effect count, [u32 base, f32 magnitude, u32 area, u32 duration, u64 conditions] per effect
+		// base effect count, [u32 base, u16 length, EDID] per base effect
+		// [4 x u16 effect index] per ingredient
+		constexpr std::uint32_t fileMagic = 'A' | 'E' << 8 | 'R' << 16 | 'D' << 24;
+		constexpr std::uint32_t fileVersion = 1;
+
+		Bytes encode(const IngredientDump& a_dump)
+		{
+			Bytes out;
+			out.reserve(16 + a_dump.ingredients.size() * 64 + a_dump.effects.size() * 24);
+			put(out, fileMagic);
+			put(out, fileVersion);
+
+			put(out, static_cast<std::uint32_t>(a_dump.ingredients.size()));
+			for (std::size_t i = 0; i < a_dump.ingredients.size(); ++i) {
+				put(out, a_dump.ingredients[i].file);
+				put(out, a_dump.ingredients[i].localFormID);
+				put(out, i < a_dump.editorIDs.size() ? a_dump.editorIDs[i] : std::string());
+			}
+
+			put(out, static_cast<std::uint32_t>(a_dump.effects.size()));
+			for (const auto& [base, magnitude, area, duration, conditions] : a_dump.effects) {
+				put(out, base);
+				put(out, magnitude);
+				put(out, area);
+				put(out, duration);
+				put(out, conditions);
+			}
+
+			put(out, static_cast<std::uint32_t>(a_dump.baseEffects.size()));
+			for (const auto& [base, editorID] : a_dump.baseEffects) {
+				put(out, base);
+				put(out, editorID);
+			}
+
+			const auto groups = std::as_bytes(std::span(a_dump.effectGroups));
+			out.insert(out.end(), groups.begin(), groups.end());
+			return out;
+		}
+	}
+
+	EffectTable IngredientDump::BuildEffectTable() const
+	{
+		EffectTable table;
+		for (const auto& effect : effects) {
+			(void)table.Intern(effect);
+		}
+		return table;
+	}
+
+	std::uint64_t IngredientDump::GetHash() const
+	{
+		return hash_bytes(encode(*this));
+	}
+
+	IngredientDump make_ingredient_dump(const EffectTable& a_table, const IngredientEffectGroups& a_effectGroups, std::vector<IngredientKey> a_ingredients, std::vector<std::string> a_editorIDs, std::vector<std::pair<BaseEffectID, std::string>> a_baseEffects)
+	{
+		IngredientDump dump{
+			.ingredients = std::move(a_ingredients),
+			.editorIDs = std::move(a_editorIDs),
+			.effects = {},
+			.baseEffects = std::move(a_baseEffects),
+			.effectGroups = a_effectGroups
+		};
+
+		// host handles mean nothing outside the game, only which effects share conditions matters
+		std::unordered_map<std::uint64_t, std::uint64_t> conditions;
+		dump.effects.reserve(a_table.size());
+		for (std::size_t i = 0; i < a_table.size(); ++i) {
+			auto effect = a_table.Get(static_cast<EffectIndex>(i));
+			if (effect.conditions != 0) {
+				effect.conditions = conditions.try_emplace(effect.conditions, conditions.size() + 1).first->second;
+			}
+			dump.effects.push_back(effect);
+		}
+		return dump;
+	}
+
+	bool write_ingredient_dump(const std::filesystem::path& a_path, const IngredientDump& a_dump)
+	{
+		return write_file_atomic(a_path, encode(a_dump));
+	}
+
+	std::optional<IngredientDump> read_ingredient_dump(const std::filesystem::path& a_path)
+	{
+		const MappedFile file(a_path);
+		if (!file) {
+			return std::nullopt;
+		}
+
+		auto           in = file.GetData();
+		std::uint32_t  magic = 0, version = 0, count = 0;
+		IngredientDump dump;
+		if (!get(in, magic) || magic != fileMagic || !get(in, version) || version != fileVersion || !get(in, count)) {
+			return std::nullopt;
+		}
+
+		dump.ingredients.resize(count);
+		dump.editorIDs.resize(count);
+		for (std::size_t i = 0; i < count; ++i) {
+			if (!get(in, dump.ingredients[i].file) || !get(in, dump.ingredients[i].localFormID) || !get(in, dump.editorIDs[i])) {
+				return std::nullopt;
+			}
+		}
+
+		if (!get(in, count) || count > EffectTable::maxSize) {
+			return std::nullopt;
+		}
+		dump.effects.resize(count);
+		for (auto& [base, magnitude, area, duration, conditions] : dump.effects) {
+			if (!get(in, base) || !get(in, magnitude) || !get(in, area) || !get(in, duration) || !get(in, conditions)) {
+				return std::nullopt;
+			}
+		}
+
+		if (!get(in, count)) {
+			return std::nullopt;
+		}
+		dump.baseEffects.resize(count);
+		for (auto& [base, editorID] : dump.baseEffects) {
+			if (!get(in, base) || !get(in, editorID)) {
+				return std::nullopt;
+			}
+		}
+
+		if (in.size() != dump.ingredients.size() * sizeof(IngredientEffects)) {
+			return std::nullopt;
+		}
+		dump.effectGroups.resize(dump.ingredients.size());
+		std::memcpy(dump.effectGroups.data(), in.data(), in.size());
+
+		const auto valid = std::ranges::all_of(dump.effectGroups, [&](const IngredientEffects& a_effectGroup) {
+			return std::ranges::all_of(a_effectGroup, [&](EffectIndex a_effect) { return a_effect < dump.effects.size(); });
+		});
+		return valid ? std::make_optional(std::move(dump)) : std::nullopt;
+	}
+}
@@ -0,0 +1,486 @@
+#include "Randomizer/KnownEffects.h"
+#include "Randomizer/MappedFile.h"
+#include "Randomizer/Serialize.h"
+
+namespace Randomizer
+{
+	namespace
+	{
+		using namespace serialize;
+
+		// files start with magic + version, only these versions are read
+		// v2 snapshot : body
+		// v3 record   : u64 parent snapshot hash, body (delta)
+		// body        : file count, [u16 length, name] per plugin, entry count, [u16 file, u32 local FormID, u16 flags] per ingredient
+		constexpr std::uint32_t fileMagic = 'A' | 'E' << 8 | 'R' << 16 | 'K' << 24;
+		constexpr std::uint32_t snapshotVersion = 2;
+		constexpr std::uint32_t recordVersion = 3;
+		constexpr auto          fileExtension = ".bin";
+		constexpr auto          snapshotFolder = "Snapshots";
+
+		// saves are rebased onto a new snapshot once their delta grows past this
+		constexpr std::size_t maxDeltaEntries = 64;
+
+		void put_body(Bytes& a_out, const KnownEffectsRecord& a_record)
+		{
+			put(a_out, static_cast<std::uint32_t>(a_record.files.size()));
+			for (const auto& file : a_record.files) {
+				put(a_out, file);
+			}
+			put(a_out, static_cast<std::uint32_t>(a_record.entries.size()));
+			for (const auto& [file, localFormID, flags] : a_record.entries) {
+				put(a_out, static_cast<std::uint16_t>(file));
+				put(a_out, localFormID);
+				put(a_out, flags);
+			}
+		}
+
+		std::optional<KnownEffectsRecord> get_body(std::span<const std::byte> a_in)
+		{
+			std::uint32_t fileCount = 0, entryCount = 0;
+			if (!get(a_in, fileCount)) {
+				return std::nullopt;
+			}
+
+			KnownEffectsRecord record;
+			record.files.resize(fileCount);
+			for (auto& file : record.files) {
+				if (!get(a_in, file)) {
+					return std::nullopt;
+				}
+			}
+
+			if (!get(a_in, entryCount)) {
+				return std::nullopt;
+			}
+			record.entries.resize(entryCount);
+			for (auto& [file, localFormID, flags] : record.entries) {
+				std::uint16_t fileIdx = 0;
+				if (!get(a_in, fileIdx) || !get(a_in, localFormID) || !get(a_in, flags) || fileIdx >= fileCount) {
+					return std::nullopt;
+				}
+				file = fileIdx;
+			}
+			return record;
+		}
+
+		Bytes encode_snapshot(const KnownEffectsRecord& a_record)
+		{
+			Bytes out;
+			out.reserve(16 + a_record.files.size() * 32 + a_record.entries.size() * 8);
+			put(out, fileMagic);
+			put(out, snapshotVersion);
+			put_body(out, a_record);
+			return out;
+		}
+
+		Bytes encode_record(std::uint64_t a_parent, const KnownEffectsRecord& a_delta)
+		{
+			Bytes out;
+			out.reserve(24 + a_delta.files.size() * 32 + a_delta.entries.size() * 8);
+			put(out, fileMagic);
+			put(out, recordVersion);
+			put(out, a_parent);
+			put_body(out, a_delta);
+			return out;
+		}
+
+		// reads magic + version, leaves a_in at the payload
+		std::optional<std::uint32_t> get_version(std::span<const std::byte>& a_in)
+		{
+			std::uint32_t magic = 0, version = 0;
+			if (!get(a_in, magic) || !get(a_in, version) || magic != fileMagic) {
+				return std::nullopt;
+			}
+			return version;
+		}
+
+		// builds a record with only the plugin names its entries use
+		class RecordBuilder
+		{
+		public:
+			void Add(const std::string& a_file, std::uint32_t a_localFormID, std::uint16_t a_flags)
+			{
+				const auto [it, inserted] = fileLookup.try_emplace(a_file, static_cast<std::uint32_t>(record.files.size()));
+				if (inserted) {
+					record.files.push_back(a_file);
+				}
+				record.entries.push_back({ it->second, a_localFormID, a_flags });
+			}
+
+			void Add(const KnownEffectsRecord& a_record)
+			{
+				for (const auto& [file, localFormID, flags] : a_record.entries) {
+					Add(a_record.files[file], localFormID, flags);
+				}
+			}
+
+			// members
+			KnownEffectsRecord record;
+
+		private:
+			std::unordered_map<std::string, std::uint32_t> fileLookup;
+		};
+	}
+
+	void KnownEffects::Open(const std::filesystem::path& a_directory, FileWriter::HeldCallback a_onHeld)
+	{
+		directory = a_directory;
+
+		std::error_code ec;
+		std::filesystem::create_directories(directory / snapshotFolder, ec);
+
+		// names only, records and snapshots are read when a save needs them
+		for (const auto& folder : { directory, directory / snapshotFolder }) {
+			for (const auto& entry : std::filesystem::directory_iterator(folder, ec)) {
+				const auto& path = entry.path();
+				if (path.extension() == ".tmp") {
+					std::filesystem::remove(path, ec);  // interrupted write, the previous file is still intact
+				} else if (path.extension() == fileExtension && folder == directory) {
+					saveParents.emplace(path.stem().string(), std::nullopt);
+				}
+			}
+		}
+
+		writer = std::make_unique<FileWriter>(std::move(a_onHeld));
+	}
+
+	void KnownEffects::Migrate(const std::filesystem::path& a_legacyPath)
+	{
+		std::error_code ec;
+		if (!writer || !std::filesystem::exists(a_legacyPath, ec)) {
+			return;
+		}
+
+		std::unordered_map<std::string, IngredientKnownEffectsMap> legacyFileMaps;
+		glz::read_file(legacyFileMaps, a_legacyPath.string(), std::string());
+
+		for (auto& [save, map] : legacyFileMaps) {
+			if (!saveParents.contains(save)) {
+				legacySaveMaps.try_emplace(save, std::move(map));
+			}
+		}
+		legacyPath = a_legacyPath;
+	}
+
+	void KnownEffects::SetIngredients(std::span<const IngredientKey> a_keys, std::span<const std::string> a_editorIDs)
+	{
+		parentHash = 0;
+		parentFlags.assign(a_keys.size(), 0);
+		parentUnresolved = {};
+		currentFlags.assign(a_keys.size(), 0);
+		unresolved = {};
+
+		files.clear();
+		slotKeys.clear();
+		slotKeys.reserve(a_keys.size());
+		slotLookup.clear();
+		slotLookup.reserve(a_keys.size());
+
+		std::unordered_map<std::string, std::uint32_t> fileLookup;
+		for (std::uint32_t slot = 0; slot < a_keys.size(); ++slot) {
+			const auto& [file, localFormID] = a_keys[slot];
+			const auto [it, inserted] = fileLookup.try_emplace(file, static_cast<std::uint32_t>(files.size()));
+			if (inserted) {
+				files.push_back(file);
+			}
+			slotKeys.push_back({ it->second, localFormID, 0 });
+			slotLookup.emplace(static_cast<std::uint64_t>(it->second) << 32 | localFormID, slot);
+		}
+
+		if (legacySaveMaps.empty()) {
+			return;
+		}
+
+		std::unordered_map<std::string, std::uint32_t> editorIDLookup;
+		editorIDLookup.reserve(a_editorIDs.size());
+		for (std::uint32_t slot = 0; slot < a_editorIDs.size(); ++slot) {
+			editorIDLookup.emplace(a_editorIDs[slot], slot);
+		}
+
+		// EditorID keyed records, entries for ingredients that aren't loaded anymore are dropped.
+		// each save is stored as a delta against the previous one's snapshot where close enough
+		for (const auto& [save, map] : legacySaveMaps) {
+			std::ranges::fill(currentFlags, std::uint16_t(0));
+			for (const auto& [editorID, flags] : map) {
+				if (const auto it = editorIDLookup.find(editorID); it != editorIDLookup.end()) {
+					currentFlags[it->second] = flags;
+				}
+			}
+			Save(save);
+		}
+		legacySaveMaps.clear();
+
+		parentHash = 0;
+		std::ranges::fill(parentFlags, std::uint16_t(0));
+		std::ranges::fill(currentFlags, std::uint16_t(0));
+
+		if (!legacyPath.empty()) {
+			writer->Flush();
+			auto backupPath = legacyPath;
+			backupPath += ".bak";
+			std::error_code ec;
+			std::filesystem::rename(legacyPath, backupPath, ec);
+		}
+	}
+
+	void KnownEffects::Flush()
+	{
+		if (writer) {
+			writer->Flush();
+		}
+	}
+
+	std::filesystem::path KnownEffects::GetRecordPath(const std::string& a_save) const
+	{
+		return directory / (a_save + fileExtension);
+	}
+
+	std::filesystem::path KnownEffects::GetSnapshotPath(std::uint64_t a_hash) const
+	{
+		return directory / snapshotFolder / std::format("{:016X}{}", a_hash, fileExtension);
+	}
+
+	std::optional<std::uint32_t> KnownEffects::FindSlot(std::uint32_t a_file, std::uint32_t a_localFormID) const
+	{
+		if (const auto it = slotLookup.find(static_cast<std::uint64_t>(a_file) << 32 | a_localFormID); it != slotLookup.end()) {
+			return it->second;
+		}
+		return std::nullopt;
+	}
+
+	auto KnownEffects::ReadRecord(const std::string& a_save) const -> std::optional<SaveRecord>
+	{
+		if (const auto it = savedRecords.find(a_save); it != savedRecords.end()) {
+			return it->second;
+		}
+
+		const MappedFile           file(GetRecordPath(a_save));
+		std::span<const std::byte> in = file.GetData();
+		const auto                 version = get_version(in);
+		std::uint64_t              parent = 0;
+		if (version && *version == recordVersion && get(in, parent)) {
+			if (auto delta = get_body(in)) {
+				return SaveRecord{ parent, std::move(*delta) };
+			}
+		}
+		return std::nullopt;
+	}
+
+	const KnownEffectsRecord* KnownEffects::GetSnapshot(std::uint64_t a_hash)
+	{
+		if (a_hash == 0) {
+			return nullptr;
+		}
+		if (const auto it = snapshots.find(a_hash); it != snapshots.end()) {
+			return &it->second;
+		}
+
+		const MappedFile           file(GetSnapshotPath(a_hash));
+		std::span<const std::byte> in = file.GetData();
+		if (const auto version = get_version(in); version && *version == snapshotVersion) {
+			if (auto record = get_body(in)) {
+				return &snapshots.emplace(a_hash, std::move(*record)).first->second;
+			}
+		}
+		return nullptr;
+	}
+
+	std::uint64_t KnownEffects::GetParent(const std::string& a_save)
+	{
+		const auto it = saveParents.find(a_save);
+		if (it == saveParents.end()) {
+			return 0;
+		}
+		if (!it->second) {
+			// header only
+			const MappedFile           file(GetRecordPath(a_save));
+			std::span<const std::byte> in = file.GetData();
+			std::uint64_t              parent = 0;
+			if (const auto version = get_version(in); version && *version == recordVersion) {
+				get(in, parent);
+			}
+			it->second = parent;
+		}
+		return *it->second;
+	}
+
+	void KnownEffects::Resolve(const KnownEffectsRecord& a_record, std::vector<std::uint16_t>& a_flags, KnownEffectsRecord& a_unresolved) const
+	{
+		// record file index -> current file index
+		std::vector<std::optional<std::uint32_t>> fileMap(a_record.files.size());
+		for (std::size_t i = 0; i < a_record.files.size(); ++i) {
+			if (const auto file = std::ranges::find(files, a_record.files[i]); file != files.end()) {
+				fileMap[i] = static_cast<std::uint32_t>(file - files.begin());
+			}
+		}
+
+		RecordBuilder builder;
+		builder.Add(a_unresolved);
+		for (const auto& entry : a_record.entries) {
+			if (const auto file = fileMap[entry.file]) {
+				if (const auto slot = FindSlot(*file, entry.localFormID)) {
+					a_flags[*slot] = entry.flags;
+					continue;
+				}
+			}
+			builder.Add(a_record.files[entry.file], entry.localFormID, entry.flags);
+		}
+		a_unresolved = std::move(builder.record);
+	}
+
+	std::uint64_t KnownEffects::AddSnapshot(const KnownEffectsRecord& a_record)
+	{
+		auto       data = encode_snapshot(a_record);
+		const auto hash = hash_bytes(data);
+		if (const auto [it, inserted] = snapshots.try_emplace(hash, a_record); inserted && writer) {
+			writer->Write(GetSnapshotPath(hash), std::move(data));  // may already be on disk, rewritten with the same bytes
+		}
+		return hash;
+	}
+
+	void KnownEffects::ScanReferences()
+	{
+		if (referencesScanned) {
+			return;
+		}
+		referencesScanned = true;
+
+		// record headers only, deferred until a snapshot could become unreferenced
+		for (const auto& save : saveParents | std::views::keys) {
+			if (const auto parent = GetParent(save); parent != 0) {
+				snapshotRefs[parent]++;
+			}
+		}
+
+		// snapshots left behind by saves deleted while the game wasn't running
+		std::error_code ec;
+		for (const auto& entry : std::filesystem::directory_iterator(directory / snapshotFolder, ec)) {
+			const auto    name = entry.path().stem().string();
+			std::uint64_t hash = 0;
+			if (const auto [ptr, err] = std::from_chars(name.data(), name.data() + name.size(), hash, 16); err == std::errc() && !snapshotRefs.contains(hash) && hash != parentHash) {
+				snapshots.erase(hash);
+				if (writer) {
+					writer->Remove(entry.path());
+				}
+			}
+		}
+	}
+
+	void KnownEffects::Reference(std::uint64_t a_hash)
+	{
+		if (referencesScanned && a_hash != 0) {
+			snapshotRefs[a_hash]++;
+		}
+	}
+
+	void KnownEffects::Release(std::uint64_t a_hash)
+	{
+		if (a_hash == 0) {
+			return;
+		}
+		ScanReferences();
+		if (const auto it = snapshotRefs.find(a_hash); it != snapshotRefs.end() && --it->second == 0) {
+			snapshotRefs.erase(it);
+			if (a_hash != parentHash) {
+				snapshots.erase(a_hash);
+				if (writer) {
+					writer->Remove(GetSnapshotPath(a_hash));
+				}
+			}
+		}
+	}
+
+	std::size_t KnownEffects::GetCurrentSize() const
+	{
+		const auto is_known = [](const auto& a_entry) { return a_entry.flags != 0; };
+		return std::ranges::count_if(currentFlags, [](auto a_flags) { return a_flags != 0; }) +
+		       std::ranges::count_if(parentUnresolved.entries, is_known) +
+		       std::ranges::count_if(unresolved.entries, is_known);
+	}
+
+	void KnownEffects::Load(const std::string& a_save)
+	{
+		parentHash = 0;
+		std::ranges::fill(parentFlags, std::uint16_t(0));
+		parentUnresolved = {};
+		unresolved = {};
+
+		if (const auto record = ReadRecord(a_save)) {
+			if (const auto snapshot = GetSnapshot(record->parent)) {
+				parentHash = record->parent;
+				Resolve(*snapshot, parentFlags, parentUnresolved);
+			}
+			currentFlags = parentFlags;
+			Resolve(record->delta, currentFlags, unresolved);
+		} else {
+			std::ranges::fill(currentFlags, std::uint16_t(0));
+		}
+	}
+
+	void KnownEffects::Save(const std::string& a_save)
+	{
+		RecordBuilder delta;
+		for (std::uint32_t slot = 0; slot < currentFlags.size(); ++slot) {
+			if (currentFlags[slot] != parentFlags[slot]) {
+				delta.Add(files[slotKeys[slot].file], slotKeys[slot].localFormID, currentFlags[slot]);
+			}
+		}
+		delta.Add(unresolved);
+
+		// rebase onto a snapshot of the full table, later saves in this playthrough share it
+		if (parentHash == 0 || delta.record.entries.size() > maxDeltaEntries) {
+			RecordBuilder missing;
+			missing.Add(parentUnresolved);
+			missing.Add(unresolved);
+
+			RecordBuilder full;
+			for (std::uint32_t slot = 0; slot < currentFlags.size(); ++slot) {
+				if (currentFlags[slot] != 0) {
+					full.Add(files[slotKeys[slot].file], slotKeys[slot].localFormID, currentFlags[slot]);
+				}
+			}
+			full.Add(missing.record);
+
+			parentHash = AddSnapshot(full.record);
+			parentFlags = currentFlags;
+			parentUnresolved = std::move(missing.record);
+			unresolved = {};
+			delta = {};
+		}
+
+		Release(GetParent(a_save));
+		saveParents[a_save] = parentHash;
+		Reference(parentHash);
+
+		auto& record = savedRecords[a_save];
+		record = { parentHash, std::move(delta.record) };
+		if (writer) {
+			// never on disk without its snapshot
+			writer->Write(GetRecordPath(a_save), encode_record(record.parent, record.delta), record.parent != 0 ? GetSnapshotPath(record.parent) : std::filesystem::path{});
+		}
+	}
+
+	void KnownEffects::Delete(const std::string& a_save)
+	{
+		const auto parent = GetParent(a_save);
+		saveParents.erase(a_save);
+		savedRecords.erase(a_save);
+		legacySaveMaps.erase(a_save);
+		Release(parent);
+		if (writer) {
+			writer->Remove(GetRecordPath(a_save));
+		}
+	}
+
+	void build_keep_masks(std::span<const std::uint16_t> a_knownEffectFlags, bool a_keepKnownEffects, std::span<std::uint16_t> a_keepMasks)
+	{
+		// branchless so the loop vectorizes
+		constexpr std::uint16_t effectBits = 0xF;
+		const std::uint16_t     keep = a_keepKnownEffects ? effectBits : 0;
+		const auto              count = std::min(a_knownEffectFlags.size(), a_keepMasks.size());
+		for (std::size_t i = 0; i < count; ++i) {
+			a_keepMasks[i] = static_cast<std::uint16_t>(~effectBits | (a_knownEffectFlags[i] & keep));
+		}
+	}
+}
@@ -0,0 +1,87 @@
+#include "Randomizer/MappedFile.h"
+
+#ifdef _WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	define NOMINMAX
+#	include <Windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+namespace Randomizer
+{
+	MappedFile::MappedFile(const std::filesystem::path& a_path)
+	{
+#ifdef _WIN32
+		const auto file = ::CreateFileW(a_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return;
+		}
+		LARGE_INTEGER size{};
+		if (::GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+			mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping) {
+				if (const auto view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) {
+					data = { static_cast<const std::byte*>(view), static_cast<std::size_t>(size.QuadPart) };
+				} else {
+					::CloseHandle(mapping);
+					mapping = nullptr;
+				}
+			}
+		}
+		::CloseHandle(file);  // the mapping keeps the file open
+#else
+		const auto file = ::open(a_path.c_str(), O_RDONLY);
+		if (file < 0) {
+			return;
+		}
+		struct stat info{};
+		if (::fstat(file, &info) == 0 && info.st_size > 0) {
+			if (const auto view = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0); view != MAP_FAILED) {
+				data = { static_cast<const std::byte*>(view), static_cast<std::size_t>(info.st_size) };
+			}
+		}
+		::close(file);
+#endif
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	MappedFile::MappedFile(MappedFile&& a_rhs) noexcept
+	{
+		*this = std::move(a_rhs);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& a_rhs) noexcept
+	{
+		if (this != &a_rhs) {
+			Close();
+			data = std::exchange(a_rhs.data, {});
+#ifdef _WIN32
+			mapping = std::exchange(a_rhs.mapping, nullptr);
+#endif
+		}
+		return *this;
+	}
+
+	void MappedFile::Close()
+	{
+		if (data.empty()) {
+			return;
+		}
+#ifdef _WIN32
+		::UnmapViewOfFile(data.data());
+		::CloseHandle(mapping);
+		mapping = nullptr;
+#else
+		::munmap(const_cast<std::byte*>(data.data()), data.size());
+#endif
+		data = {};
+	}
+}
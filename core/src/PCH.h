@@ -0,0 +1,31 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <ranges>
+#include <set>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ClibUtil/rng.hpp"
+#include <glaze/glaze.hpp>
+
+namespace Randomizer
+{
+	using RNG = XoshiroCpp::Xoshiro256StarStar;  // raw engine, streams are split with jump()
+}
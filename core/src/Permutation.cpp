@@ -0,0 +1,125 @@
+#include "Randomizer/Permutation.h"
+
+namespace Randomizer
+{
+	namespace
+	{
+		// splitmix64 finalizer
+		std::uint64_t mix(std::uint64_t a_value)
+		{
+			a_value ^= a_value >> 30;
+			a_value *= 0xBF58476D1CE4E5B9;
+			a_value ^= a_value >> 27;
+			a_value *= 0x94D049BB133111EB;
+			a_value ^= a_value >> 31;
+			return a_value;
+		}
+
+		// materialized groups per pool task
+		constexpr std::size_t groupsPerTask = 4096;
+	}
+
+	FeistelPermutation::FeistelPermutation(std::uint64_t a_seed, std::uint32_t a_size) :
+		size(a_size)
+	{
+		auto state = a_seed;
+		for (auto& key : keys) {
+			state += 0x9E3779B97F4A7C15;
+			key = mix(state);
+		}
+
+		// smallest power of two covering the range, so cycle-walking takes < 2 steps on average
+		std::uint32_t bits = 0;
+		while ((std::uint64_t(1) << bits) < a_size) {
+			bits++;
+		}
+		rightBits = bits / 2;
+		leftMask = (std::uint32_t(1) << (bits - rightBits)) - 1;
+		rightMask = (std::uint32_t(1) << rightBits) - 1;
+	}
+
+	std::uint32_t FeistelPermutation::Encrypt(std::uint32_t a_index) const
+	{
+		// multiplicative hash, the high half of the product depends on every key bit
+		const auto round = [](std::uint32_t a_half, std::uint64_t a_key) {
+			return static_cast<std::uint32_t>(((a_half ^ a_key) * 0x9E3779B97F4A7C15) >> 32);
+		};
+
+		// the halves differ by a bit for odd widths, so they alternate in place instead of swapping
+		auto left = a_index >> rightBits;
+		auto right = a_index & rightMask;
+		for (std::size_t i = 0; i < rounds; i += 2) {
+			left ^= round(right, keys[i]) & leftMask;
+			right ^= round(left, keys[i + 1]) & rightMask;
+		}
+		return (left << rightBits) | right;
+	}
+
+	KeyedShuffle::KeyedShuffle(std::uint64_t a_seed, std::size_t a_groupCount, std::vector<SlotPatch> a_patches) :
+		seed(a_seed),
+		permutation(a_seed, static_cast<std::uint32_t>(a_groupCount * 4))
+	{
+		if (a_patches.empty()) {
+			return;
+		}
+
+		std::ranges::sort(a_patches, {}, &SlotPatch::first);
+		patchedBits.assign((a_groupCount * 4 + 63) / 64, 0);
+		patchRanks.assign(patchedBits.size(), 0);
+		patchEffects.reserve(a_patches.size());
+		for (const auto& [slot, effect] : a_patches) {
+			patchedBits[slot / 64] |= std::uint64_t(1) << (slot % 64);
+			patchEffects.push_back(effect);
+		}
+		for (std::size_t word = 1; word < patchedBits.size(); ++word) {
+			patchRanks[word] = patchRanks[word - 1] + static_cast<std::uint32_t>(std::popcount(patchedBits[word - 1]));
+		}
+	}
+
+	EffectIndex KeyedShuffle::GetEffect(const IngredientEffectGroups& a_original, std::size_t a_slot) const
+	{
+		if (!patchEffects.empty()) {
+			const auto bits = patchedBits[a_slot / 64];
+			if (const auto bit = std::uint64_t(1) << (a_slot % 64); (bits & bit) != 0) {
+				return patchEffects[patchRanks[a_slot / 64] + std::popcount(bits & (bit - 1))];
+			}
+		}
+		return get_slot(a_original, permutation(static_cast<std::uint32_t>(a_slot)));
+	}
+
+	IngredientEffects KeyedShuffle::GetGroup(const IngredientEffectGroups& a_original, std::size_t a_group) const
+	{
+		return { GetEffect(a_original, a_group * 4), GetEffect(a_original, a_group * 4 + 1), GetEffect(a_original, a_group * 4 + 2), GetEffect(a_original, a_group * 4 + 3) };
+	}
+
+	void KeyedShuffle::Materialize(const IngredientEffectGroups& a_original, IngredientEffectGroups& a_effectGroups, ThreadPool* a_pool) const
+	{
+		const auto groupCount = a_original.size();
+		a_effectGroups.resize(groupCount);
+
+		const auto taskCount = (groupCount + groupsPerTask - 1) / groupsPerTask;
+		const auto materialize = [&](std::size_t a_task) {
+			const auto end = std::min(groupCount, (a_task + 1) * groupsPerTask);
+			for (auto group = a_task * groupsPerTask; group < end; ++group) {
+				for (std::size_t i = 0; i < 4; ++i) {
+					a_effectGroups[group][i] = get_slot(a_original, permutation(static_cast<std::uint32_t>(group * 4 + i)));
+				}
+			}
+		};
+
+		if (a_pool && taskCount > 1) {
+			a_pool->ParallelFor(taskCount, materialize);
+		} else {
+			for (std::size_t i = 0; i < taskCount; ++i) {
+				materialize(i);
+			}
+		}
+
+		auto patch = patchEffects.begin();
+		for (std::size_t word = 0; word < patchedBits.size(); ++word) {
+			for (auto bits = patchedBits[word]; bits != 0; bits &= bits - 1) {
+				get_slot(a_effectGroups, word * 64 + std::countr_zero(bits)) = *patch++;
+			}
+		}
+	}
+}
@@ -0,0 +1,81 @@
+#include "Randomizer/ReverseIndex.h"
+
+namespace Randomizer
+{
+	void ReverseIndex::Build(const EffectTable& a_table, const IngredientEffectGroups& a_effectGroups)
+	{
+		offsets.assign(a_table.GetBaseCount() + 1, 0);
+		slotBases.resize(a_effectGroups.size() * 4);
+
+		for (std::size_t slot = 0; slot < a_effectGroups.size(); ++slot) {
+			for (std::size_t i = 0; i < 4; ++i) {
+				const auto base = a_table.GetBase(a_effectGroups[slot][i]);
+				slotBases[slot * 4 + i] = base;
+				offsets[base + 1]++;
+			}
+		}
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+		// filled in slot order, so every list comes out sorted
+		slots.resize(slotBases.size());
+		std::vector<std::uint32_t> next(offsets.begin(), offsets.end() - 1);
+		for (std::size_t effectSlot = 0; effectSlot < slotBases.size(); ++effectSlot) {
+			slots[next[slotBases[effectSlot]]++] = static_cast<std::uint32_t>(effectSlot / 4);
+		}
+	}
+
+	bool ReverseIndex::Update(const EffectTable& a_table, const IngredientEffectGroups& a_effectGroups, std::span<const std::uint32_t> a_groups)
+	{
+		if (slotBases.size() != a_effectGroups.size() * 4 || GetBaseCount() != a_table.GetBaseCount()) {
+			Build(a_table, a_effectGroups);
+			return false;
+		}
+
+		// (base, slot) entries leaving and joining lists. An ingredient that only reordered its effects cancels out
+		std::vector<std::pair<BaseIndex, std::uint32_t>> removed;
+		std::vector<std::pair<BaseIndex, std::uint32_t>> added;
+		for (const auto slot : a_groups) {
+			for (std::size_t i = 0; i < 4; ++i) {
+				auto&      listed = slotBases[slot * 4 + i];
+				const auto base = a_table.GetBase(a_effectGroups[slot][i]);
+				if (listed != base) {
+					removed.emplace_back(listed, slot);
+					added.emplace_back(base, slot);
+					listed = base;
+				}
+			}
+		}
+		if (removed.empty()) {
+			return true;
+		}
+		std::ranges::sort(removed);
+		std::ranges::sort(added);
+
+		std::vector<std::uint32_t> kept;
+		for (std::size_t r = 0, a = 0; r < removed.size() || a < added.size();) {
+			const auto base = std::min(r < removed.size() ? removed[r].first : BaseIndex(-1), a < added.size() ? added[a].first : BaseIndex(-1));
+			auto       rEnd = r;
+			auto       aEnd = a;
+			while (rEnd < removed.size() && removed[rEnd].first == base) {
+				++rEnd;
+			}
+			while (aEnd < added.size() && added[aEnd].first == base) {
+				++aEnd;
+			}
+
+			const auto list = std::span(slots).subspan(offsets[base], offsets[base + 1] - offsets[base]);
+			kept.clear();
+			std::ranges::set_difference(list, std::ranges::subrange(removed.begin() + r, removed.begin() + rEnd) | std::views::values, std::back_inserter(kept));
+			if (kept.size() + (aEnd - a) != list.size()) {
+				Build(a_table, a_effectGroups);
+				return false;
+			}
+			std::ranges::merge(kept, std::ranges::subrange(added.begin() + a, added.begin() + aEnd) | std::views::values, list.begin());
+
+			r = rEnd;
+			a = aEnd;
+		}
+
+		return true;
+	}
+}
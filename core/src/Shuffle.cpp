@@ -0,0 +1,422 @@
+#include "Randomizer/Shuffle.h"
+
+#include "Randomizer/Conflicts.h"
+
+namespace Randomizer
+{
+	namespace
+	{
+		// hard cap on random partner draws, per effect slot, before falling back to the constructive layout
+		constexpr std::uint64_t repairAttemptsPerSlot = 32;
+
+		// random partner draws per slot in a partial reshuffle, a slot keeps its effect if none fits
+		constexpr std::uint32_t reshuffleAttemptsPerSlot = 32;
+
+		// fixed so the partition layout only depends on the ingredient count, never on the machine
+		constexpr std::size_t groupsPerPartition = 1024;
+
+		using Groups = std::span<IngredientEffects>;
+
+		bool group_has_base(Groups a_groups, std::span<const BaseIndex> a_bases, std::size_t a_slot, BaseIndex a_base)
+		{
+			const auto& effectGroup = a_groups[a_slot / 4];
+			const auto  skip = a_slot % 4;
+			for (std::size_t i = 0; i < 4; ++i) {
+				if (i != skip && a_bases[effectGroup[i]] == a_base) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// every base effect must fit in a distinct group
+		std::optional<std::pair<BaseIndex, std::size_t>> find_overflow(const IngredientEffectGroups& a_effectGroups, const EffectTable& a_table)
+		{
+			std::vector<std::size_t> counts(a_table.GetBaseCount(), 0);
+			for (const auto& effectGroup : a_effectGroups) {
+				for (const auto& effect : effectGroup) {
+					counts[a_table.GetBase(effect)]++;
+				}
+			}
+			const auto it = std::ranges::max_element(counts);
+			if (it != counts.end() && *it > a_effectGroups.size()) {
+				return std::make_pair(static_cast<BaseIndex>(it - counts.begin()), *it);
+			}
+			return std::nullopt;
+		}
+
+		// in-place Fisher-Yates over every slot
+		void shuffle_slots(IngredientEffectGroups& a_effectGroups, RNG& a_rng)
+		{
+			for (auto slot = a_effectGroups.size() * 4 - 1; slot > 0; --slot) {
+				std::swap(get_slot(a_effectGroups, slot), get_slot(a_effectGroups, static_cast<std::size_t>(a_rng() % (slot + 1))));
+			}
+		}
+
+		// swap each duplicate slot with a random slot elsewhere in a_groups, keeping both groups duplicate-free
+		bool repair_slots(Groups a_groups, std::span<const BaseIndex> a_bases, RNG& a_rng, std::uint32_t& a_repairs)
+		{
+			ConflictIndex conflicts(a_groups, a_bases);
+			if (conflicts.GetCount() == 0) {
+				return true;
+			}
+			if (a_groups.size() < 2) {
+				return false;
+			}
+
+			const auto slotCount = a_groups.size() * 4;
+			const auto slot_at = [&](std::size_t a_slot) -> EffectIndex& { return a_groups[a_slot / 4][a_slot % 4]; };
+
+			std::uint64_t budget = slotCount * repairAttemptsPerSlot;
+
+			// a repair never dirties a clean group, so a single forward sweep meets every conflict and stops at the last one
+			for (std::size_t group = 0; group < a_groups.size() && conflicts.GetCount() > 0; ++group) {
+				if (!conflicts.IsConflicted(group)) {
+					continue;
+				}
+				const auto groupStart = group * 4;
+				for (auto slot = groupStart; slot < groupStart + 4; ++slot) {
+					while (group_has_base(a_groups, a_bases, slot, a_bases[slot_at(slot)])) {
+						if (budget-- == 0) {
+							return false;
+						}
+						// any slot outside this group
+						auto partner = static_cast<std::size_t>(a_rng() % (slotCount - 4));
+						if (partner >= groupStart) {
+							partner += 4;
+						}
+						if (!group_has_base(a_groups, a_bases, slot, a_bases[slot_at(partner)]) && !group_has_base(a_groups, a_bases, partner, a_bases[slot_at(slot)])) {
+							std::swap(slot_at(slot), slot_at(partner));
+							conflicts.Update(partner / 4);
+							a_repairs++;
+						}
+					}
+				}
+				conflicts.Update(group);
+			}
+
+			return true;
+		}
+
+		// deal slots sorted by base effect round-robin across groups, a base occupying at most one slot per group.
+		// always succeeds if no base effect overflows
+		void construct_slots(IngredientEffectGroups& a_effectGroups, const EffectTable& a_table, RNG& a_rng)
+		{
+			const auto groupCount = a_effectGroups.size();
+
+			std::vector<std::uint64_t> baseOrder(a_table.GetBaseCount());
+			for (auto& order : baseOrder) {
+				order = a_rng();
+			}
+
+			std::vector<EffectIndex> slots(groupCount * 4);
+			for (std::size_t slot = 0; slot < slots.size(); ++slot) {
+				slots[slot] = get_slot(a_effectGroups, slot);
+			}
+			std::ranges::stable_sort(slots, {}, [&](EffectIndex a_effect) { return baseOrder[a_table.GetBase(a_effect)]; });
+
+			std::vector<std::size_t> groupOrder(groupCount);
+			std::iota(groupOrder.begin(), groupOrder.end(), 0);
+			std::ranges::shuffle(groupOrder, a_rng);
+
+			for (std::size_t i = 0; i < slots.size(); ++i) {
+				a_effectGroups[groupOrder[i % groupCount]][i / groupCount] = slots[i];
+			}
+		}
+
+		// one pass over per-base slot counts : clamp each base to [min, max], then level the total back to every slot.
+		// surplus is taken from the most common bases, shortfall goes to the rarest. Slots are then rewritten,
+		// dropped or copied at random within each base so magnitude variants keep their mix
+		bool rebalance_slots(IngredientEffectGroups& a_effectGroups, const EffectTable& a_table, const ShuffleConstraints& a_constraints, RNG& a_rng, ShuffleResult& a_result)
+		{
+			const auto groupCount = a_effectGroups.size();
+			const auto slotCount = groupCount * 4;
+
+			std::vector<EffectIndex> slots(slotCount);
+			for (std::size_t slot = 0; slot < slotCount; ++slot) {
+				slots[slot] = get_slot(a_effectGroups, slot);
+			}
+			std::ranges::shuffle(slots, a_rng);
+
+			// counting sort by base, runs stay in shuffled order
+			const auto               baseCount = a_table.GetBaseCount();
+			std::vector<std::size_t> offsets(baseCount + 1, 0);
+			for (const auto effect : slots) {
+				offsets[a_table.GetBase(effect) + 1]++;
+			}
+			std::inclusive_scan(offsets.begin(), offsets.end(), offsets.begin());
+			std::vector<EffectIndex> byBase(slotCount);
+			{
+				auto next = offsets;
+				for (const auto effect : slots) {
+					byBase[next[a_table.GetBase(effect)]++] = effect;
+				}
+			}
+
+			const auto count_of = [&](std::size_t a_base) { return offsets[a_base + 1] - offsets[a_base]; };
+
+			std::vector<BaseIndex> present;
+			for (std::size_t base = 0; base < baseCount; ++base) {
+				if (count_of(base) > 0) {
+					present.push_back(static_cast<BaseIndex>(base));
+				}
+			}
+			a_result.baseCount = present.size();
+
+			const std::size_t low = a_constraints.minPerBase;
+			const std::size_t high = a_constraints.maxPerBase != 0 ? std::min<std::size_t>(a_constraints.maxPerBase, groupCount) : groupCount;
+			if (present.size() * low > slotCount || low > high) {
+				a_result.status = ShuffleResult::STATUS::kUnsatisfiable;
+				a_result.boundSlots = present.size() * low;
+				return false;
+			}
+			if (present.size() * high < slotCount) {
+				a_result.status = ShuffleResult::STATUS::kUnsatisfiable;
+				a_result.boundSlots = present.size() * high;
+				return false;
+			}
+
+			std::vector<std::size_t> targets(baseCount, 0);
+			std::size_t              total = 0;
+			for (const auto base : present) {
+				targets[base] = std::clamp(count_of(base), low, high);
+				total += targets[base];
+			}
+
+			// random tie-break, so equally common bases are picked in seed order rather than form order
+			std::vector<std::uint64_t> tieBreak(baseCount);
+			for (auto& value : tieBreak) {
+				value = a_rng();
+			}
+			using Entry = std::pair<std::size_t, std::uint64_t>;  // target, tie-break
+			const auto level = [&](bool a_lower) {
+				std::vector<std::pair<Entry, BaseIndex>> heap;
+				for (const auto base : present) {
+					if (a_lower ? targets[base] > low : targets[base] < high) {
+						heap.push_back({ { targets[base], tieBreak[base] }, base });
+					}
+				}
+				// max-heap on target to lower, min-heap to raise
+				const auto compare = [a_lower](const auto& a_lhs, const auto& a_rhs) { return a_lower ? a_lhs.first < a_rhs.first : a_rhs.first < a_lhs.first; };
+				std::ranges::make_heap(heap, compare);
+				while (total != slotCount) {
+					std::ranges::pop_heap(heap, compare);
+					auto& [entry, base] = heap.back();
+					targets[base] = a_lower ? targets[base] - 1 : targets[base] + 1;
+					total = a_lower ? total - 1 : total + 1;
+					if (a_lower ? targets[base] > low : targets[base] < high) {
+						entry.first = targets[base];
+						std::ranges::push_heap(heap, compare);
+					} else {
+						heap.pop_back();
+					}
+				}
+			};
+			if (total > slotCount) {
+				level(true);
+			} else if (total < slotCount) {
+				level(false);
+			}
+
+			std::size_t slot = 0;
+			for (const auto base : present) {
+				const auto run = std::span(byBase).subspan(offsets[base], count_of(base));
+				for (std::size_t i = 0; i < targets[base]; ++i) {
+					get_slot(a_effectGroups, slot++) = run[i % run.size()];
+				}
+				if (targets[base] > run.size()) {
+					a_result.rebalanced += static_cast<std::uint32_t>(targets[base] - run.size());
+				}
+			}
+
+			return true;
+		}
+
+		// repair each partition on its own stream, partitions are spread over the pool
+		// but the result only depends on the seed and the slots
+		std::uint32_t repair_partitions(IngredientEffectGroups& a_effectGroups, std::span<const BaseIndex> a_bases, const RNG& a_rng, ThreadPool* a_pool, ShuffleResult& a_result)
+		{
+			const auto groupCount = a_effectGroups.size();
+			const auto partitionCount = std::max<std::size_t>(1, groupCount / groupsPerPartition);
+
+			// partition N draws from the seed's stream advanced by N + 1 jumps (2^128 steps each), streams never overlap
+			std::vector<RNG> streams;
+			streams.reserve(partitionCount);
+			RNG stream = a_rng;
+			for (std::size_t i = 0; i < partitionCount; ++i) {
+				stream.jump();
+				streams.push_back(stream);
+			}
+
+			std::vector<std::uint32_t> repairs(partitionCount, 0);
+			std::vector<std::uint8_t>  repaired(partitionCount, false);
+
+			const auto repair_partition = [&](std::size_t a_partition) {
+				const auto begin = a_partition * groupCount / partitionCount;
+				const auto end = (a_partition + 1) * groupCount / partitionCount;
+				repaired[a_partition] = repair_slots(Groups(a_effectGroups).subspan(begin, end - begin), a_bases, streams[a_partition], repairs[a_partition]);
+			};
+
+			if (a_pool && partitionCount > 1) {
+				a_pool->ParallelFor(partitionCount, repair_partition);
+			} else {
+				for (std::size_t i = 0; i < partitionCount; ++i) {
+					repair_partition(i);
+				}
+			}
+
+			a_result.partitions = static_cast<std::uint32_t>(partitionCount);
+			a_result.repairs = std::reduce(repairs.begin(), repairs.end());
+			a_result.failedPartitions = static_cast<std::uint32_t>(std::ranges::count(repaired, false));
+			a_result.partitionRepairs = std::move(repairs);
+
+			return a_result.failedPartitions;
+		}
+
+		// partitions that couldn't be fixed locally (base effect crowding one partition) get a pass over every slot
+		void repair_shuffled_slots(IngredientEffectGroups& a_effectGroups, const EffectTable& a_table, RNG& a_rng, ThreadPool* a_pool, ShuffleResult& a_result)
+		{
+			const auto bases = a_table.GetBases();
+			if (repair_partitions(a_effectGroups, bases, a_rng, a_pool, a_result) > 0 && !repair_slots(a_effectGroups, bases, a_rng, a_result.repairs)) {
+				a_result.constructed = true;
+				construct_slots(a_effectGroups, a_table, a_rng);
+			}
+		}
+	}
+
+	bool is_distribution_unique(const EffectTable& a_table, const IngredientEffectGroups& a_effectGroups)
+	{
+		const auto bases = a_table.GetBases();
+		return std::ranges::none_of(a_effectGroups, [&](const IngredientEffects& a_effectGroup) {
+			return has_duplicate_base(a_effectGroup, bases);
+		});
+	}
+
+	ShuffleResult shuffle_effect_groups(const std::uint64_t a_seed, SHUFFLE_METHOD a_method, const EffectTable& a_table, IngredientEffectGroups& a_effectGroups, ThreadPool* a_pool, const ShuffleConstraints& a_constraints)
+	{
+		RNG local_rng(a_seed);
+
+		ShuffleResult result;
+		result.groupCount = a_effectGroups.size();
+
+		switch (a_method) {
+		case SHUFFLE_METHOD::kSwap:
+			{
+				// swap effect groups around
+				std::ranges::shuffle(a_effectGroups, local_rng);
+			}
+			break;
+		case SHUFFLE_METHOD::kShuffle:
+		case SHUFFLE_METHOD::kConstrained:
+		case SHUFFLE_METHOD::kPermutation:
+			{
+				if (a_effectGroups.size() < 2) {
+					break;
+				}
+
+				if (a_method == SHUFFLE_METHOD::kConstrained) {
+					// counts are capped at the ingredient count, nothing can overflow afterwards
+					if (!rebalance_slots(a_effectGroups, a_table, a_constraints, local_rng, result)) {
+						break;
+					}
+				} else if (const auto overflow = find_overflow(a_effectGroups, a_table)) {
+					result.status = ShuffleResult::STATUS::kImpossible;
+					result.overflowBase = a_table.GetBaseID(overflow->first);
+					result.overflowCount = overflow->second;
+					break;
+				}
+
+				// initial shuffle, distribution probably contains duplicates
+				if (a_method == SHUFFLE_METHOD::kPermutation) {
+					IngredientEffectGroups permuted;
+					KeyedShuffle(a_seed, a_effectGroups.size()).Materialize(a_effectGroups, permuted, a_pool);
+					a_effectGroups = std::move(permuted);
+				} else {
+					shuffle_slots(a_effectGroups, local_rng);
+				}
+
+				repair_shuffled_slots(a_effectGroups, a_table, local_rng, a_pool, result);
+			}
+			break;
+		default:
+			break;
+		}
+
+		return result;
+	}
+
+	KeyedShuffle make_keyed_shuffle(std::uint64_t a_seed, const EffectTable& a_table, const IngredientEffectGroups& a_original, ThreadPool* a_pool, ShuffleResult& a_result)
+	{
+		RNG local_rng(a_seed);
+
+		a_result = ShuffleResult{};
+		a_result.groupCount = a_original.size();
+
+		KeyedShuffle keyed(a_seed, a_original.size());
+		if (a_original.size() < 2) {
+			return keyed;
+		}
+		if (const auto overflow = find_overflow(a_original, a_table)) {
+			a_result.status = ShuffleResult::STATUS::kImpossible;
+			a_result.overflowBase = a_table.GetBaseID(overflow->first);
+			a_result.overflowCount = overflow->second;
+			return keyed;
+		}
+
+		// same slots as shuffle_effect_groups(kPermutation), diffed against the bare permutation
+		IngredientEffectGroups permuted;
+		keyed.Materialize(a_original, permuted, a_pool);
+		auto effectGroups = permuted;
+		repair_shuffled_slots(effectGroups, a_table, local_rng, a_pool, a_result);
+
+		std::vector<SlotPatch> patches;
+		for (std::size_t slot = 0; slot < effectGroups.size() * 4; ++slot) {
+			if (const auto effect = get_slot(effectGroups, slot); effect != get_slot(permuted, slot)) {
+				patches.emplace_back(static_cast<std::uint32_t>(slot), effect);
+			}
+		}
+		a_result.patches = patches.size();
+
+		return KeyedShuffle(a_seed, a_original.size(), std::move(patches));
+	}
+
+	std::vector<SlotSwap> reshuffle_effect_groups(std::uint64_t a_seed, const EffectTable& a_table, IngredientEffectGroups& a_effectGroups, std::span<const std::uint32_t> a_groups)
+	{
+		std::vector<SlotSwap> swaps;
+		if (a_effectGroups.size() < 2) {
+			return swaps;
+		}
+
+		RNG        local_rng(a_seed);
+		const auto bases = a_table.GetBases();
+		const auto slotCount = a_effectGroups.size() * 4;
+
+		for (const auto group : a_groups) {
+			if (group >= a_effectGroups.size()) {
+				continue;
+			}
+			const auto groupStart = static_cast<std::size_t>(group) * 4;
+			for (auto slot = groupStart; slot < groupStart + 4; ++slot) {
+				for (std::uint32_t attempt = 0; attempt < reshuffleAttemptsPerSlot; ++attempt) {
+					// any slot outside this group
+					auto partner = static_cast<std::size_t>(local_rng() % (slotCount - 4));
+					if (partner >= groupStart) {
+						partner += 4;
+					}
+					const auto effect = get_slot(a_effectGroups, slot);
+					const auto partnerEffect = get_slot(a_effectGroups, partner);
+					if (effect == partnerEffect) {
+						continue;
+					}
+					if (!group_has_base(a_effectGroups, bases, slot, bases[partnerEffect]) && !group_has_base(a_effectGroups, bases, partner, bases[effect])) {
+						std::swap(get_slot(a_effectGroups, slot), get_slot(a_effectGroups, partner));
+						swaps.emplace_back(static_cast<std::uint32_t>(slot), static_cast<std::uint32_t>(partner));
+						break;
+					}
+				}
+			}
+		}
+
+		return swaps;
+	}
+}
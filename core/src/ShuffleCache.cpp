@@ -0,0 +1,96 @@
+#include "Randomizer/ShuffleCache.h"
+#include "Randomizer/MappedFile.h"
+#include "Randomizer/Serialize.h"
+
+namespace Randomizer
+{
+	namespace
+	{
+		using namespace serialize;
+
+		// magic + version, input hash, group count, [4 x u16 effect index] per group
+		constexpr std::uint32_t fileMagic = 'A' | 'E' << 8 | 'R' << 16 | 'S' << 24;
+		constexpr std::uint32_t fileVersion = 1;
+
+		template <class T>
+		std::uint64_t hash_value(T a_value, std::uint64_t a_hash)
+		{
+			return hash_bytes(std::as_bytes(std::span(&a_value, 1)), a_hash);
+		}
+	}
+
+	std::uint64_t hash_shuffle_input(std::uint64_t a_seed, SHUFFLE_METHOD a_method, const ShuffleConstraints& a_constraints, const EffectTable& a_table, const IngredientEffectGroups& a_original, std::span<const IngredientKey> a_ingredients)
+	{
+		auto hash = hash_value(shuffleVersion, hash_bytes({}));
+		hash = hash_value(a_seed, hash);
+		hash = hash_value(a_method, hash);
+		if (a_method == SHUFFLE_METHOD::kConstrained) {
+			hash = hash_value(a_constraints.minPerBase, hash);
+			hash = hash_value(a_constraints.maxPerBase, hash);
+		}
+
+		hash = hash_value(a_table.size(), hash);
+		for (std::size_t i = 0; i < a_table.size(); ++i) {
+			const auto& effect = a_table.Get(static_cast<EffectIndex>(i));
+			hash = hash_value(effect.base, hash);
+			hash = hash_value(effect.magnitude, hash);
+			hash = hash_value(effect.area, hash);
+			hash = hash_value(effect.duration, hash);
+			hash = hash_value(effect.conditions != 0, hash);
+		}
+
+		hash = hash_value(a_original.size(), hash);
+		hash = hash_bytes(std::as_bytes(std::span(a_original)), hash);
+
+		hash = hash_value(a_ingredients.size(), hash);
+		for (const auto& [file, localFormID] : a_ingredients) {
+			hash = hash_value(file.size(), hash);
+			hash = hash_bytes(std::as_bytes(std::span(file)), hash);
+			hash = hash_value(localFormID, hash);
+		}
+
+		return hash;
+	}
+
+	std::optional<IngredientEffectGroups> read_shuffle_cache(const std::filesystem::path& a_path, std::uint64_t a_key, const EffectTable& a_table)
+	{
+		const MappedFile file(a_path);
+		if (!file) {
+			return std::nullopt;
+		}
+
+		auto          in = file.GetData();
+		std::uint32_t magic = 0, version = 0, count = 0;
+		std::uint64_t key = 0;
+		if (!get(in, magic) || magic != fileMagic || !get(in, version) || version != fileVersion || !get(in, key) || key != a_key || !get(in, count)) {
+			return std::nullopt;
+		}
+		if (in.size() != std::size_t(count) * sizeof(IngredientEffects)) {
+			return std::nullopt;
+		}
+
+		IngredientEffectGroups effectGroups(count);
+		std::memcpy(effectGroups.data(), in.data(), in.size());
+
+		const auto valid = std::ranges::all_of(effectGroups, [&](const IngredientEffects& a_effectGroup) {
+			return std::ranges::all_of(a_effectGroup, [&](EffectIndex a_effect) { return a_effect < a_table.size(); });
+		});
+		return valid ? std::make_optional(std::move(effectGroups)) : std::nullopt;
+	}
+
+	bool write_shuffle_cache(const std::filesystem::path& a_path, std::uint64_t a_key, const IngredientEffectGroups& a_effectGroups)
+	{
+		Bytes out;
+		out.reserve(20 + a_effectGroups.size() * sizeof(IngredientEffects));
+		put(out, fileMagic);
+		put(out, fileVersion);
+		put(out, a_key);
+		put(out, static_cast<std::uint32_t>(a_effectGroups.size()));
+		const auto groups = std::as_bytes(std::span(a_effectGroups));
+		out.insert(out.end(), groups.begin(), groups.end());
+
+		std::error_code ec;
+		std::filesystem::create_directories(a_path.parent_path(), ec);
+		return write_file_atomic(a_path, out);
+	}
+}
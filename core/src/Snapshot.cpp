@@ -0,0 +1,52 @@
+#include "Randomizer/Snapshot.h"
+
+namespace Randomizer
+{
+	EpochDomain::~EpochDomain()
+	{
+		for (const auto& [ptr, destroy, retiredEpoch] : retired) {
+			destroy(ptr);
+		}
+	}
+
+	EpochDomain::Pin EpochDomain::Enter()
+	{
+		// the epoch may advance before the slot is claimed, pinning an older one only delays frees
+		const auto current = epoch.load();
+		for (;;) {
+			for (auto& slot : slots) {
+				std::uint64_t expected = 0;
+				if (slot.epoch.compare_exchange_strong(expected, current)) {
+					return Pin(slot.epoch);
+				}
+			}
+			std::this_thread::yield();
+		}
+	}
+
+	void EpochDomain::Retire(void* a_ptr, Deleter a_delete)
+	{
+		std::scoped_lock lock(retiredLock);
+		// readers pinned after this can only see what replaced a_ptr
+		retired.push_back({ a_ptr, a_delete, epoch.fetch_add(1) });
+		Collect();
+	}
+
+	void EpochDomain::Collect()
+	{
+		auto oldestPin = std::numeric_limits<std::uint64_t>::max();
+		for (const auto& slot : slots) {
+			if (const auto pinned = slot.epoch.load(); pinned != 0) {
+				oldestPin = std::min(oldestPin, pinned);
+			}
+		}
+
+		std::erase_if(retired, [&](const Retired& a_retired) {
+			if (a_retired.epoch < oldestPin) {
+				a_retired.destroy(a_retired.ptr);
+				return true;
+			}
+			return false;
+		});
+	}
+}
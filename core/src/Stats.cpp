@@ -0,0 +1,102 @@
+#include "Randomizer/Stats.h"
+
+namespace Randomizer
+{
+	void Stats::SetVersion(std::string_view a_version)
+	{
+		std::scoped_lock guard(lock);
+		data.version = a_version;
+	}
+
+	void Stats::AddTime(std::string_view a_phase, double a_ms)
+	{
+		std::scoped_lock guard(lock);
+		auto&            phase = data.phases[std::string(a_phase)];
+		phase.calls++;
+		phase.totalMs += a_ms;
+		phase.maxMs = std::max(phase.maxMs, a_ms);
+		phase.lastMs = a_ms;
+	}
+
+	void Stats::AddCount(std::string_view a_counter, std::uint64_t a_value)
+	{
+		std::scoped_lock guard(lock);
+		data.counters[std::string(a_counter)] += a_value;
+	}
+
+	void Stats::SetCount(std::string_view a_counter, std::uint64_t a_value)
+	{
+		std::scoped_lock guard(lock);
+		data.counters[std::string(a_counter)] = a_value;
+	}
+
+	void Stats::AddShuffle(std::uint64_t a_seed, SHUFFLE_METHOD a_method, double a_ms, const ShuffleResult& a_result)
+	{
+		const auto method = [&]() {
+			switch (a_method) {
+			case SHUFFLE_METHOD::kSwap:
+				return "swap";
+			case SHUFFLE_METHOD::kShuffle:
+				return "shuffle";
+			case SHUFFLE_METHOD::kConstrained:
+				return "constrained";
+			case SHUFFLE_METHOD::kPermutation:
+				return "permutation";
+			default:
+				return "unknown";
+			}
+		};
+
+		ShuffleStats shuffle{
+			.seed = a_seed,
+			.method = method(),
+			.groups = a_result.groupCount,
+			.ms = a_ms,
+			.repairs = a_result.repairs,
+			.partitions = a_result.partitions,
+			.failedPartitions = a_result.failedPartitions,
+			.partitionRepairs = a_result.partitionRepairs,
+			.rebalanced = a_result.rebalanced,
+			.patches = a_result.patches,
+			.constructed = a_result.constructed,
+			.impossible = !a_result.success()
+		};
+
+		std::scoped_lock guard(lock);
+		if (data.shuffles.size() == maxShuffles) {
+			data.shuffles.erase(data.shuffles.begin());
+		}
+		data.shuffles.push_back(std::move(shuffle));
+	}
+
+	StatsData Stats::GetData() const
+	{
+		std::scoped_lock guard(lock);
+		return data;
+	}
+
+	std::vector<std::string> Stats::GetSummary() const
+	{
+		std::scoped_lock guard(lock);
+
+		std::vector<std::string> lines;
+		for (const auto& [name, phase] : data.phases) {
+			lines.push_back(std::format("{} : {} calls | {:.3f} ms total | {:.3f} ms max", name, phase.calls, phase.totalMs, phase.maxMs));
+		}
+		for (const auto& [name, value] : data.counters) {
+			lines.push_back(std::format("{} : {}", name, value));
+		}
+		if (!data.shuffles.empty()) {
+			const auto& last = data.shuffles.back();
+			const auto  maxRepairs = last.partitionRepairs.empty() ? 0 : std::ranges::max(last.partitionRepairs);
+			lines.push_back(std::format("last shuffle : {} groups | {:.3f} ms | {} repairs | {} partitions ({} failed, max {} repairs)", last.groups, last.ms, last.repairs, last.partitions, last.failedPartitions, maxRepairs));
+		}
+		return lines;
+	}
+
+	void Stats::Write(const std::filesystem::path& a_path) const
+	{
+		std::scoped_lock      guard(lock);  // also keeps concurrent writers off the file
+		[[maybe_unused]] auto ec = glz::write_file_json(data, a_path.string(), std::string());
+	}
+}
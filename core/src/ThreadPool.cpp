@@ -0,0 +1,151 @@
+#include "Randomizer/ThreadPool.h"
+
+namespace Randomizer
+{
+	namespace
+	{
+		constexpr auto noWorker = std::numeric_limits<std::size_t>::max();
+
+		thread_local const ThreadPool* currentPool{ nullptr };
+		thread_local std::size_t       currentWorker{ noWorker };
+	}
+
+	ThreadPool::ThreadPool(std::size_t a_threadCount)
+	{
+		queues.reserve(a_threadCount);
+		for (std::size_t i = 0; i < a_threadCount; ++i) {
+			queues.push_back(std::make_unique<Queue>());
+		}
+		threads.reserve(a_threadCount);
+		for (std::size_t i = 0; i < a_threadCount; ++i) {
+			threads.emplace_back([this, i](std::stop_token a_stop) { WorkerLoop(a_stop, i); });
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		for (auto& thread : threads) {
+			thread.request_stop();
+		}
+		idle.notify_all();
+		threads.clear();
+	}
+
+	void ThreadPool::Push(Task a_task)
+	{
+		if (queues.empty()) {
+			a_task();
+			return;
+		}
+
+		// counted before it can be popped, so pending never drops below the queued tasks
+		{
+			std::scoped_lock lock(idleLock);
+			pending++;
+		}
+
+		// workers keep their own subtasks local, everyone else spreads round-robin
+		const auto index = currentPool == this ? currentWorker : nextQueue++ % queues.size();
+		{
+			std::scoped_lock lock(queues[index]->lock);
+			queues[index]->tasks.push_back(std::move(a_task));
+		}
+		idle.notify_one();
+	}
+
+	bool ThreadPool::TryPop(std::size_t a_index, Task& a_task)
+	{
+		if (!PopFrom(a_index, a_task)) {
+			return false;
+		}
+		std::scoped_lock lock(idleLock);
+		pending--;
+		return true;
+	}
+
+	bool ThreadPool::PopFrom(std::size_t a_index, Task& a_task)
+	{
+		if (a_index != noWorker) {
+			auto&            own = *queues[a_index];
+			std::scoped_lock lock(own.lock);
+			if (!own.tasks.empty()) {
+				a_task = std::move(own.tasks.back());
+				own.tasks.pop_back();
+				return true;
+			}
+		}
+
+		for (std::size_t offset = 1; offset <= queues.size(); ++offset) {
+			const auto victim = a_index == noWorker ? offset - 1 : (a_index + offset) % queues.size();
+			if (victim == a_index) {
+				continue;
+			}
+			auto&            other = *queues[victim];
+			std::scoped_lock lock(other.lock);
+			if (!other.tasks.empty()) {
+				a_task = std::move(other.tasks.front());
+				other.tasks.pop_front();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void ThreadPool::WorkerLoop(std::stop_token a_stop, std::size_t a_index)
+	{
+		currentPool = this;
+		currentWorker = a_index;
+
+		Task task;
+		while (!a_stop.stop_requested()) {
+			if (TryPop(a_index, task)) {
+				task();
+				task = nullptr;
+				continue;
+			}
+			std::unique_lock lock(idleLock);
+			idle.wait(lock, a_stop, [this] { return pending > 0; });
+		}
+	}
+
+	void ThreadPool::ParallelFor(std::size_t a_count, const std::function<void(std::size_t)>& a_func)
+	{
+		if (a_count == 0) {
+			return;
+		}
+
+		// helpers may start after the caller has returned, so the shared state outlives this frame
+		struct State
+		{
+			std::atomic<std::size_t>               next{ 0 };
+			std::atomic<std::size_t>               done{ 0 };
+			std::size_t                            count{ 0 };
+			const std::function<void(std::size_t)>* func{ nullptr };
+		};
+
+		auto state = std::make_shared<State>();
+		state->count = a_count;
+		state->func = &a_func;
+
+		const auto run = [](State& a_state) {
+			for (auto i = a_state.next++; i < a_state.count; i = a_state.next++) {
+				(*a_state.func)(i);
+				if (++a_state.done == a_state.count) {
+					a_state.done.notify_all();
+				}
+			}
+		};
+
+		const auto helpers = std::min(a_count - 1, threads.size());
+		for (std::size_t i = 0; i < helpers; ++i) {
+			Push([state, run]() { run(*state); });
+		}
+
+		run(*state);
+
+		for (auto done = state->done.load(); done != a_count; done = state->done.load()) {
+			state->done.wait(done);
+		}
+	}
+}
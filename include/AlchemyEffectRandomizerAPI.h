@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+// Public API for other SKSE plugins, published through the SKSE messaging interface.
+//
+// Register a listener for "AlchemyEffectsRandomizer" in SKSEPlugin_Load. Every time ingredient effects change
+// (data load, shuffles, alchemy menu reshuffles), a kEffectIndex message is broadcast with an EffectIndex as data.
+// Plugins that load late can send kRequestEffectIndex to "AlchemyEffectsRandomizer", the current index is sent
+// back to them only.
+
+namespace RE
+{
+	class IngredientItem;
+}
+
+namespace AlchemyEffectRandomizer::API
+{
+	inline constexpr const char*   pluginName = "AlchemyEffectsRandomizer";
+	inline constexpr std::uint32_t version = 1;
+
+	enum : std::uint32_t
+	{
+		kRequestEffectIndex = 0x41455251,  // "AERQ", no data
+		kEffectIndex = 0x41455249          // "AERI", data : const EffectIndex*, dataLen : sizeof(EffectIndex) of the sender
+	};
+
+	// Base effect (EffectSetting) -> ingredients that currently carry it, as flat CSR arrays.
+	// Effects are numbered 0 to effectCount - 1, ingredients 0 to ingredientCount - 1, both only change on data load.
+	// The arrays are owned by the randomizer and only valid until the next kEffectIndex message, copy what you keep.
+	struct EffectIndex
+	{
+		std::uint32_t version;          // API version the randomizer was built with, fields are only ever appended
+		std::uint32_t generation;       // incremented every time ingredient effects change
+		std::uint32_t effectCount;
+		std::uint32_t ingredientCount;
+
+		const std::uint32_t*       effectFormIDs;      // [effectCount] effect -> EffectSetting FormID
+		const std::uint32_t*       sortedEffects;      // [effectCount] effects ordered by FormID, see FindEffect
+		RE::IngredientItem* const* ingredients;        // [ingredientCount] ingredient -> form
+		const std::uint32_t*       ingredientOffsets;  // [effectCount + 1] effect -> first entry of ingredientList
+		const std::uint32_t*       ingredientList;     // [ingredientOffsets[effectCount]] ingredients grouped by effect, sorted
+
+		// ingredients carrying an effect, empty if a_effect is out of range (e.g. FindEffect found nothing)
+		[[nodiscard]] std::span<const std::uint32_t> GetIngredients(std::uint32_t a_effect) const
+		{
+			if (a_effect >= effectCount) {
+				return {};
+			}
+			return { ingredientList + ingredientOffsets[a_effect], ingredientList + ingredientOffsets[a_effect + 1] };
+		}
+
+		// effectCount if no ingredient carries the EffectSetting
+		[[nodiscard]] std::uint32_t FindEffect(std::uint32_t a_formID) const
+		{
+			std::uint32_t first = 0;
+			std::uint32_t count = effectCount;
+			while (count > 0) {
+				const auto step = count / 2;
+				if (effectFormIDs[sortedEffects[first + step]] < a_formID) {
+					first += step + 1;
+					count -= step + 1;
+				} else {
+					count = step;
+				}
+			}
+			return first < effectCount && effectFormIDs[sortedEffects[first]] == a_formID ? sortedEffects[first] : effectCount;
+		}
+	};
+}
@@ -1,6 +0,0 @@
-#pragma once
-
-namespace Hooks
-{
-	void Install();
-}
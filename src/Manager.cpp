@@ -1,5 +1,4 @@
 #include "Manager.h"
-#include "Hooks.h"
 
 void Manager::LoadSettings()
 {
@@ -10,16 +9,25 @@ void Manager::LoadSettings()
 
 	ini.LoadFile(path.c_str());
 
-	ini::get_value(ini, shuffleMethod, "Settings", "iRandomMethod", ";Method\n;0 - Swap (ingredient effect groups with each other)\n;1 - Shuffle (all effects across each ingredient)");
+	ini::get_value(ini, shuffleMethod, "Settings", "iRandomMethod", ";Method\n;0 - Swap (ingredient effect groups with each other)\n;1 - Shuffle (all effects across each ingredient)\n;2 - Constrained (Shuffle, but every effect ends up on at least iMinIngredientsPerEffect ingredients)\n;3 - Permutation (Shuffle, computed from the seed on demand. Uses less memory per cached playthrough)");
+	ini::get_value(ini, shuffleConstraints.minPerBase, "Settings", "iMinIngredientsPerEffect", ";Constrained method : minimum number of ingredients sharing each effect. Effects found on a single ingredient can't be crafted.");
+	ini::get_value(ini, shuffleConstraints.maxPerBase, "Settings", "iMaxIngredientsPerEffect", ";Constrained method : maximum number of ingredients sharing each effect. If 0, there is no limit.");
 	ini::get_value(ini, shuffleOn, "Settings", "iRandomizeOn", ";When to apply the randomizer\n;0 - Game Load (randomized on game load)\n;1 - Playthrough (randomized across different playthroughs)\n;2 - Alchemy Menu (randomized on game load and every time you craft a potion!)");
+	ini::get_value(ini, reshuffleUsedIngredients, "Settings", "bReshuffleUsedIngredients", ";Alchemy Menu mode : only reshuffle the ingredients used to craft potions, instead of every ingredient.");
 	ini::get_value(ini, unlearnIngredients, "Settings", "bUnlearnIngredients", ";Unlearn all ingredients upon randomization (for Playthrough mode, this happens only once).");
 	ini::get_value(ini, fixedSeed, "Settings", "iSeed", ";Fixed RNG seed (for OnGameLoad randomization). If 0, ingredients will have different effects on each game load.");
+	ini::get_value(ini, workerThreads, "Settings", "iWorkerThreads", ";Background threads used for shuffling. If 0, uses all cores but one.");
+	ini::get_value(ini, exportIngredients, "Settings", "bExportIngredients", ";Write the eligible ingredients and their effects next to the SKSE log after data load, for the offline RandomizerBatch tool.");
+	ini::get_value(ini, playthroughCacheSize, "Settings", "iPlaythroughCacheSize", ";Playthrough randomizations kept in memory. Older ones are regenerated from their seed when that character is loaded again.");
+	ini::get_value(ini, logLevel, "Settings", "iLogLevel", ";Log verbosity\n;0 - Warnings (warnings and errors only)\n;1 - Summary (skipped ingredients and blacklist misses are counted, with a few examples)\n;2 - Verbose (every skipped ingredient and blacklist miss is listed)");
 
 	(void)ini.SaveFile(path.c_str());
 }
 
 void Manager::LoadBlacklist()
 {
+	const auto timer = stats.Time("LoadBlacklist");
+
 	logger::info("{:*^30}", "INI");
 
 	const auto folderPath = std::format(R"(Data\{})", folder);
@@ -38,79 +46,258 @@ void Manager::LoadBlacklist()
 
 	logger::info("{} matching inis found", configs.size());
 
-	for (auto& path : configs) {
-		logger::info("\tINI : {}", path);
+	const auto configHash = Randomizer::hash_configs(configs);
+	if (auto cache = Randomizer::read_blacklist_cache(blacklistCachePath); cache && cache->configHash == configHash) {
+		blacklistRules = std::move(cache->rules);
+		logger::info("\t{} blacklist entries (cached, inis unchanged)", blacklistRules.size());
+		return;
+	}
+
+	struct Config
+	{
+		Randomizer::BlacklistRules rules;
+		SI_Error                   rc{ SI_OK };
+	};
 
+	// parsed across the pool, merged and logged in config order
+	std::vector<Config> parsed(configs.size());
+	threadPool->ParallelFor(configs.size(), [&](std::size_t a_index) {
 		CSimpleIniA ini;
 		ini.SetUnicode();
 		ini.SetAllowKeyOnly();
 
-		if (const auto rc = ini.LoadFile(path.c_str()); rc < 0) {
-			logger::error("	couldn't read INI");
-			continue;
+		auto& [rules, rc] = parsed[a_index];
+		if (rc = ini.LoadFile(configs[a_index].c_str()); rc < 0) {
+			return;
 		}
 
 		if (const auto values = ini.GetSection("Blacklist"); values && !values->empty()) {
-			logger::info("\t\t{} blacklist entries", values->size());
 			for (const auto& key : *values | std::views::keys) {
-				blacklistIDs.emplace(key.pItem);
+				rules.Add(key.pItem);
 			}
 		}
+	});
+
+	for (std::size_t i = 0; i < configs.size(); ++i) {
+		logger::info("\tINI : {}", configs[i]);
+
+		const auto& [rules, rc] = parsed[i];
+		if (rc < 0) {
+			logger::error("	couldn't read INI");
+			continue;
+		}
+		if (!rules.empty()) {
+			logger::info("\t\t{} blacklist entries ({} EditorIDs, {} prefixes, {} plugins)", rules.size(), rules.editorIDs.size(), rules.prefixes.size(), rules.plugins.size());
+			blacklistRules.Merge(rules);
+		}
 	}
+
+	threadPool->Submit([this, cache = Randomizer::BlacklistCache{ configHash, blacklistRules }]() {
+		if (!Randomizer::write_blacklist_cache(blacklistCachePath, cache)) {
+			logger::warn("Blacklist: couldn't write cache to {}", blacklistCachePath);
+		}
+	});
 }
 
 void Manager::OnPostLoad()
 {
 	LoadSettings();
+
+	switch (logLevel) {
+	case LOG_LEVEL::kWarning:
+		spdlog::set_level(spdlog::level::warn);
+		break;
+	case LOG_LEVEL::kVerbose:
+		spdlog::set_level(spdlog::level::debug);
+		break;
+	default:
+		break;
+	}
+
+	if (const auto path = logger::log_directory()) {
+		statsPath = *path / std::format("{}_Stats.json", Version::PROJECT);
+		ingredientDumpPath = *path / std::format("{}_Ingredients.bin", Version::PROJECT);
+	}
+	stats.SetVersion(Version::NAME);
+
+	if (workerThreads == 0) {
+		workerThreads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+	}
+	threadPool = std::make_unique<Randomizer::ThreadPool>(workerThreads);
+	logger::info("Worker threads : {}", workerThreads);
+
 	LoadBlacklist();
 
-	glz::read_file(ingredientKnownEffectsSaveMap, ingredientKnownEffectsPath, std::string());
+	playthroughEffectGroupMap.SetCapacity(playthroughCacheSize);
 
-	Hooks::Install();
+	knownEffects.Open(knownEffectsFolder, [](const std::filesystem::path& a_path, bool a_dropped) {
+		if (a_dropped) {
+			logger::error("Known effects: couldn't write {}, giving up", a_path.string());
+		} else {
+			logger::warn("Known effects: couldn't write {}, retrying in the background", a_path.string());
+		}
+	});
+	knownEffects.Migrate(ingredientKnownEffectsPath);
 }
 
 void Manager::InitBlacklist()
 {
 	logger::info("{:*^30}", "LOADING BLACKLIST");
 
-	for (auto& id : blacklistIDs) {
-		if (auto form = RE::TESForm::LookupByEditorID<RE::IngredientItem>(id)) {
-			blacklist.emplace(form);
-		} else {
-			logger::error("Blacklist: skipped {} (couldn't find form)", id);
+	const auto dataHandler = RE::TESDataHandler::GetSingleton();
+	if (!dataHandler || blacklistRules.empty()) {
+		logger::info("Blacklist: {} ingredients", blacklist.size());
+		return;
+	}
+
+	// one pass over the ingredients, redone every launch so plugins updated in place are matched again
+	const Randomizer::BlacklistMatcher   matcher(blacklistRules);
+	std::unordered_set<std::string_view> matched;  // rules that hit at least one ingredient
+	std::vector<std::string>             missingEditorIDs;
+	std::vector<std::string>             emptyPlugins;
+
+	for (const auto ingredient : dataHandler->GetFormArray<RE::IngredientItem>()) {
+		if (!ingredient) {
+			continue;
+		}
+		const auto file = ingredient->GetFile(0);
+		if (const auto match = matcher.Match(file ? file->GetFilename() : ""sv, edid::get_editorID(ingredient))) {
+			blacklist.emplace(ingredient);
+			matched.insert(match->entry);
+		}
+	}
+
+	for (const auto& id : blacklistRules.editorIDs) {
+		if (!matched.contains(id)) {
+			missingEditorIDs.push_back(id);
+		}
+	}
+	for (const auto& plugin : blacklistRules.plugins) {
+		if (!matched.contains(plugin)) {
+			emptyPlugins.push_back(plugin);
 		}
 	}
+	log_coalesced(spdlog::level::err, "blacklisted EditorIDs skipped (couldn't find form)", missingEditorIDs);
+	log_coalesced(spdlog::level::info, "blacklisted plugins add no ingredients", emptyPlugins);
 
 	logger::info("Blacklist: {} ingredients", blacklist.size());
 }
 
 void Manager::LoadIngredientEffects()
 {
+	const auto timer = stats.Time("LoadIngredientEffects");
+
 	logger::info("{:*^30}", "LOADING INGREDIENTS");
 
 	if (const auto dataHandler = RE::TESDataHandler::GetSingleton()) {
 		const auto& ingredients = dataHandler->GetFormArray<RE::IngredientItem>();
 
+		std::vector<Randomizer::IngredientKey> ingredientKeys;
+		std::vector<std::string>               editorIDs;
+		std::vector<std::string>               nullEffectGroups;
+		std::vector<std::string>               nonstandardEffectGroups;
+
+		eligibleIngredients = Randomizer::EligibilityIndex(ingredients.size());
 		originalEffectGroups.reserve(ingredients.size());
-		for (const auto& ingredient : ingredients) {
+		effects.reserve(ingredients.size() * 4);
+		for (std::uint32_t position = 0; position < ingredients.size(); ++position) {
+			const auto ingredient = ingredients[position];
 			if (ingredient && !blacklist.contains(ingredient)) {
 				if (ingredient->effects.size() == 4) {
 					if (std::ranges::all_of(ingredient->effects, [](const auto* effect) { return effect && effect->baseEffect; })) {
-						originalEffectGroups.emplace_back(ingredient->effects.begin(), ingredient->effects.end());
+						auto& effectGroup = originalEffectGroups.emplace_back();
+						for (std::size_t i = 0; i < 4; ++i) {
+							const auto effect = ingredient->effects[i];
+							const auto index = effectTable.Intern({ effect->baseEffect->GetFormID(), effect->effectItem.magnitude, effect->effectItem.area, effect->effectItem.duration, reinterpret_cast<std::uintptr_t>(effect->conditions.head) });
+							if (!index) {
+								logger::error("More than {} unique ingredient effects, randomization disabled", Randomizer::EffectTable::maxSize);
+								originalEffectGroups.clear();
+								eligibleIngredients = {};
+								ingredientSlots.clear();
+								return;
+							}
+							effectGroup[i] = *index;
+							effects.push_back(effect);
+						}
+						ingredientSlots.emplace_back(ingredient, static_cast<std::uint32_t>(eligibleIngredients.size()));
+						eligibleIngredients.Add(position);
+						if (const auto file = ingredient->GetFile(0)) {
+							ingredientKeys.push_back({ std::string(file->GetFilename()), ingredient->GetLocalFormID() });
+						} else {
+							ingredientKeys.push_back({ std::string(), ingredient->GetFormID() });
+						}
+						editorIDs.push_back(edid::get_editorID(ingredient));
 					} else {
-						logger::info("{} has null effect groups, skipping", edid::get_editorID(ingredient));
+						nullEffectGroups.push_back(edid::get_editorID(ingredient));
 						blacklist.emplace(ingredient);
 					}
 				} else {
-					logger::info("{} has nonstandard effect groups, skipping (size : {})", edid::get_editorID(ingredient), ingredient->effects.size());
+					nonstandardEffectGroups.push_back(std::format("{} (size : {})", edid::get_editorID(ingredient), ingredient->effects.size()));
 					blacklist.emplace(ingredient);
 				}
 			}
 		}
+
+		log_coalesced(spdlog::level::info, "ingredients have null effect groups, skipping", nullEffectGroups);
+		log_coalesced(spdlog::level::info, "ingredients have nonstandard effect groups, skipping", nonstandardEffectGroups);
+
+		knownEffects.SetIngredients(ingredientKeys, editorIDs);
+
+		// fixed seed game load randomization gives the same result every launch until an input changes
+		if (shuffleOn == SHUFFLE_ON::kGameLoad && fixedSeed != 0 && !originalEffectGroups.empty()) {
+			shuffleCacheKey = Randomizer::hash_shuffle_input(fixedSeed, shuffleMethod, shuffleConstraints, effectTable, originalEffectGroups, ingredientKeys);
+		}
+
+		if (exportIngredients && !originalEffectGroups.empty()) {
+			ExportIngredients(std::move(ingredientKeys), std::move(editorIDs));
+		}
 	}
 
-	logger::info("EffectGroups: {} ({} effects)", originalEffectGroups.size(), originalEffectGroups.size() * 4);
+	effectInstances = Randomizer::EffectInstances(originalEffectGroups, effectTable.size());
+	appliedEffects = Randomizer::AppliedEffects(originalEffectGroups);
+	liveEffectGroups.Store(originalEffectGroups);
+	std::ranges::sort(ingredientSlots);
+	BuildEffectIndex();
+
+	logger::info("EffectGroups: {} ({} effects, {} unique)", originalEffectGroups.size(), originalEffectGroups.size() * 4, effectTable.size());
 	logger::info("Blacklist: {} ingredients", blacklist.size());
+
+	stats.SetCount("Ingredients", originalEffectGroups.size());
+	stats.SetCount("UniqueEffects", effectTable.size());
+	stats.SetCount("BaseEffects", effectTable.GetBaseCount());
+	stats.SetCount("BlacklistedIngredients", blacklist.size());
+}
+
+void Manager::ExportIngredients(std::vector<Randomizer::IngredientKey> a_keys, std::vector<std::string> a_editorIDs) const
+{
+	if (ingredientDumpPath.empty() || !threadPool) {
+		return;
+	}
+
+	std::vector<std::pair<Randomizer::BaseEffectID, std::string>> baseEffects;
+	baseEffects.reserve(effectTable.GetBaseCount());
+	for (std::size_t base = 0; base < effectTable.GetBaseCount(); ++base) {
+		const auto baseID = effectTable.GetBaseID(static_cast<Randomizer::BaseIndex>(base));
+		baseEffects.emplace_back(baseID, edid::get_editorID(RE::TESForm::LookupByID<RE::EffectSetting>(baseID)));
+	}
+
+	auto dump = Randomizer::make_ingredient_dump(effectTable, originalEffectGroups, std::move(a_keys), std::move(a_editorIDs), std::move(baseEffects));
+	threadPool->Submit([path = ingredientDumpPath, dump = std::move(dump)]() {
+		if (Randomizer::write_ingredient_dump(path, dump)) {
+			logger::info("Exported {} ingredients to {}", dump.ingredients.size(), path.string());
+		} else {
+			logger::warn("Couldn't export ingredients to {}", path.string());
+		}
+	});
+}
+
+std::optional<std::uint32_t> Manager::GetIngredientSlot(const RE::IngredientItem* a_ingredient) const
+{
+	const auto it = std::ranges::lower_bound(ingredientSlots, a_ingredient, {}, &std::pair<const RE::IngredientItem*, std::uint32_t>::first);
+	if (it != ingredientSlots.end() && it->first == a_ingredient) {
+		return it->second;
+	}
+	return std::nullopt;
 }
 
 void Manager::OnDataLoad()
@@ -122,53 +309,193 @@ void Manager::OnDataLoad()
 
 	if ((shuffleOn == SHUFFLE_ON::kGameLoad && (fixedSeed == 0 || !unlearnIngredients)) || shuffleOn == SHUFFLE_ON::kAlchemyMenu) {
 		ShuffleIngredientEffects(shuffledEffectGroups);
+		QueueNextShuffle();
+	}
+
+	// nothing was shuffled yet, other plugins still get the unshuffled index
+	if (effectIndex.generation == 0) {
+		PublishEffectIndex();
 	}
 
+	LogStats();
+	WriteStats();
+
 	logger::info("{:*^30}", "LOAD/SAVE");
 }
 
-void Manager::ApplyEffectGroups(const IngredientEffectGroups& a_effectGroups) const
+void Manager::AddEffectInstances(const Randomizer::IngredientEffectGroups& a_effectGroups)
+{
+	const auto shortfall = effectInstances.GetShortfall(a_effectGroups);
+	if (shortfall.empty()) {
+		return;
+	}
+
+	// constrained shuffles can use an effect more often than the load order does, copy the original effect
+	std::vector<std::pair<Randomizer::EffectIndex, Randomizer::InstanceID>> added;
+	for (const auto& [effectIndex, count] : shortfall) {
+		const auto source = effects[effectInstances.GetFirst(effectIndex)];
+		for (std::uint32_t i = 0; i < count; ++i) {
+			const auto effect = new RE::Effect();
+			effect->effectItem = source->effectItem;
+			effect->baseEffect = source->baseEffect;
+			effect->cost = source->cost;
+			effect->conditions.head = source->conditions.head;  // shared, ingredients are never unloaded
+			added.emplace_back(effectIndex, static_cast<Randomizer::InstanceID>(effects.size()));
+			effects.push_back(effect);
+		}
+	}
+	effectInstances.Add(added);
+
+	logger::info("\tCreated {} effect copies for the constrained distribution", added.size());
+}
+
+void Manager::ApplyEffectGroups(const Randomizer::IngredientEffectGroups& a_effectGroups)
 {
+	const auto timer = stats.Time("ApplyEffectGroups");
+
+	AddEffectInstances(a_effectGroups);
+
 	if (const auto dataHandler = RE::TESDataHandler::GetSingleton()) {
-		std::size_t outerIdx = 0;
-		for (const auto& ingredient : dataHandler->GetFormArray<RE::IngredientItem>()) {
-			if (ingredient && !blacklist.contains(ingredient)) {
-				std::size_t innerIdx = 0;  // serves as effect idx
-				for (auto& effect : ingredient->effects) {
-					effect = a_effectGroups[outerIdx][innerIdx];
-					innerIdx++;
-				}
-				if (shuffleOn != SHUFFLE_ON::kPlaythrough) {
-					UnlearnIngredientEffects(ingredient);
-				}
-				outerIdx++;
+		// only ingredients whose effects differ from what they currently hold are written and unlearned
+		const auto&                ingredients = dataHandler->GetFormArray<RE::IngredientItem>();
+		std::vector<std::uint32_t> changedSlots;
+		appliedEffects.Apply(a_effectGroups, effectInstances, [&](std::uint32_t a_slot, const Randomizer::IngredientInstances& a_instances) {
+			const auto  ingredient = ingredients[eligibleIngredients.GetPosition(a_slot)];
+			std::size_t innerIdx = 0;  // serves as effect idx
+			for (auto& effect : ingredient->effects) {
+				effect = effects[a_instances[innerIdx]];
+				innerIdx++;
 			}
+			changedSlots.push_back(a_slot);
+		});
+		if (shuffleOn != SHUFFLE_ON::kPlaythrough) {
+			UnlearnIngredientEffects(changedSlots);
+		}
+		if (!changedSlots.empty()) {
+			liveEffectGroups.Store(appliedEffects.GetEffectGroups());
+		}
+		UpdateEffectIndex(a_effectGroups, changedSlots);
+		logger::info("\tApplied {} of {} ingredients (others unchanged)", changedSlots.size(), a_effectGroups.size());
+		stats.AddCount("AppliedIngredients", changedSlots.size());
+	}
+}
+
+void Manager::ApplyEffectGroups(const ShuffledIngredientEffectGroups& a_effectGroups)
+{
+	if (!a_effectGroups.keyed) {
+		ApplyEffectGroups(a_effectGroups.groups);
+		return;
+	}
+
+	// resolved for the duration of the apply only
+	Randomizer::IngredientEffectGroups effectGroups;
+	a_effectGroups.keyed->Materialize(originalEffectGroups, effectGroups, threadPool.get());
+	ApplyEffectGroups(effectGroups);
+}
+
+void Manager::BuildEffectIndex()
+{
+	reverseIndex.Build(effectTable, originalEffectGroups);
+
+	effectFormIDs.resize(effectTable.GetBaseCount());
+	for (Randomizer::BaseIndex base = 0; base < effectFormIDs.size(); ++base) {
+		effectFormIDs[base] = effectTable.GetBaseID(base);
+	}
+	sortedEffects.resize(effectFormIDs.size());
+	std::iota(sortedEffects.begin(), sortedEffects.end(), 0);
+	std::ranges::sort(sortedEffects, {}, [&](std::uint32_t a_base) { return effectFormIDs[a_base]; });
+
+	ingredientForms.clear();
+	if (const auto dataHandler = RE::TESDataHandler::GetSingleton()) {
+		const auto& ingredients = dataHandler->GetFormArray<RE::IngredientItem>();
+		for (const auto position : eligibleIngredients.GetPositions()) {
+			ingredientForms.push_back(ingredients[position]);
 		}
 	}
 }
 
-bool Manager::can_unlearn_effect(const std::optional<std::uint16_t>& a_effectKnownFlag, std::uint32_t a_effectIdx) const
+void Manager::UpdateEffectIndex(const Randomizer::IngredientEffectGroups& a_effectGroups, std::span<const std::uint32_t> a_slots)
+{
+	if (a_slots.empty()) {
+		return;
+	}
+
+	const auto timer = stats.Time("UpdateEffectIndex");
+
+	if (!reverseIndex.Update(effectTable, a_effectGroups, a_slots)) {
+		stats.AddCount("EffectIndexRebuilds");
+	}
+	PublishEffectIndex();
+}
+
+void Manager::PublishEffectIndex(const char* a_receiver)
+{
+	if (a_receiver == nullptr) {
+		effectIndex.generation++;
+	}
+
+	effectIndex.version = AlchemyEffectRandomizer::API::version;
+	effectIndex.effectCount = static_cast<std::uint32_t>(effectFormIDs.size());
+	effectIndex.ingredientCount = static_cast<std::uint32_t>(ingredientForms.size());
+	effectIndex.effectFormIDs = effectFormIDs.data();
+	effectIndex.sortedEffects = sortedEffects.data();
+	effectIndex.ingredients = ingredientForms.data();
+	effectIndex.ingredientOffsets = reverseIndex.GetOffsets().data();
+	effectIndex.ingredientList = reverseIndex.GetSlots().data();
+
+	SKSE::GetMessagingInterface()->Dispatch(AlchemyEffectRandomizer::API::kEffectIndex, &effectIndex, sizeof(effectIndex), a_receiver);
+}
+
+void Manager::OnEffectIndexRequest(const char* a_sender)
 {
-	if (!a_effectKnownFlag) {
-		return true;
+	// before data load there is nothing to send yet, the broadcast follows
+	if (effectIndex.generation != 0 && a_sender) {
+		PublishEffectIndex(a_sender);
 	}
+}
+
+bool Manager::KeepKnownEffects() const
+{
+	return shuffleOn == SHUFFLE_ON::kPlaythrough || (shuffleOn == SHUFFLE_ON::kGameLoad && fixedSeed != 0);
+}
 
-	return shuffleOn == SHUFFLE_ON::kPlaythrough || (shuffleOn == SHUFFLE_ON::kGameLoad && fixedSeed != 0) ? (*a_effectKnownFlag && a_effectIdx) == 0 : true;
+void Manager::BuildKeepMasks()
+{
+	keepMasks.assign(eligibleIngredients.size(), static_cast<std::uint16_t>(~0xF));  // slots without a record unlearn their effects
+	Randomizer::build_keep_masks(knownEffects.GetKnownEffectFlags(), KeepKnownEffects(), keepMasks);
 }
 
-void Manager::UnlearnIngredientEffects(RE::IngredientItem* a_ingredient) const
+void Manager::UnlearnIngredientEffects(std::span<const std::uint32_t> a_slots)
 {
-	if (!unlearnIngredients || blacklist.contains(a_ingredient)) {
+	if (!unlearnIngredients || a_slots.empty()) {
 		return;
 	}
 
-	std::optional<std::uint16_t> knowEffectFlags{};
-	if (const auto it = currentIngredientKnownEffectsMap.find(edid::get_editorID(a_ingredient)); it != currentIngredientKnownEffectsMap.end()) {
-		knowEffectFlags = it->second;
+	const auto timer = stats.Time("UnlearnIngredientEffects");
+
+	if (const auto dataHandler = RE::TESDataHandler::GetSingleton()) {
+		const auto& ingredients = dataHandler->GetFormArray<RE::IngredientItem>();
+		BuildKeepMasks();
+		for (const auto slot : a_slots) {
+			ingredients[eligibleIngredients.GetPosition(slot)]->gamedata.knownEffectFlags &= keepMasks[slot];
+		}
+	}
+}
+
+void Manager::UnlearnAllIngredientEffects()
+{
+	if (!unlearnIngredients || eligibleIngredients.empty()) {
+		return;
 	}
-	for (std::uint32_t index = 0; index < 4; ++index) {
-		if (can_unlearn_effect(knowEffectFlags, index)) {
-			a_ingredient->gamedata.knownEffectFlags &= ~(1 << index);
+
+	const auto timer = stats.Time("UnlearnAllIngredientEffects");
+
+	if (const auto dataHandler = RE::TESDataHandler::GetSingleton()) {
+		const auto& ingredients = dataHandler->GetFormArray<RE::IngredientItem>();
+		const auto  positions = eligibleIngredients.GetPositions();
+		BuildKeepMasks();
+		for (std::size_t slot = 0; slot < positions.size(); ++slot) {
+			ingredients[positions[slot]]->gamedata.knownEffectFlags &= keepMasks[slot];
 		}
 	}
 }
@@ -191,89 +518,225 @@ std::uint64_t Manager::GetRNGSeed(bool a_onDataLoad) const
 	}
 }
 
-void Manager::shuffle_effect_groups(const std::uint64_t a_seed, IngredientEffectGroups& a_effectGroups) const
+void Manager::ShuffleIngredientEffects(ShuffledIngredientEffectGroups& a_effectGroups, bool a_reshuffle)
 {
-	RNG local_rng(a_seed);
+	if (originalEffectGroups.empty()) {
+		return;
+	}
+	const auto seed = GetRNGSeed();
+	const bool shuffle = a_reshuffle || (!a_effectGroups.shuffled && !ReadShuffleCache(a_effectGroups));
+	if (shuffle) {
+		ShuffleEffectGroups(seed, a_effectGroups);
+	}
+	if (!a_effectGroups.shuffled || a_reshuffle || shuffleOn == SHUFFLE_ON::kPlaythrough) {
+		ApplyEffectGroups(a_effectGroups);
+		logger::info("\tShuffled {} ingredient effects ({} individual effects | RNG seed : {})", originalEffectGroups.size(), originalEffectGroups.size() * 4, seed);
+	}
+	if (shuffle) {
+		WriteShuffleCache();
+	}
+	a_effectGroups.shuffled = true;
+}
 
-	switch (shuffleMethod) {
-	case SHUFFLE_METHOD::kSwap:
-		{
-			// swap effect groups around
-			std::ranges::shuffle(a_effectGroups, local_rng);
+void Manager::ShuffleEffectGroups(std::uint64_t a_seed, ShuffledIngredientEffectGroups& a_effectGroups) const
+{
+	if (shuffleMethod != SHUFFLE_METHOD::kPermutation) {
+		if (a_effectGroups.groups.empty()) {
+			a_effectGroups.groups.assign(originalEffectGroups.begin(), originalEffectGroups.end());
 		}
-		break;
-	case SHUFFLE_METHOD::kShuffle:
-		{
-			constexpr auto shuffle_effects = [](IngredientEffectGroups& a_ingredients, RNG& a_rng) {
-				// flatten
-				auto effects = a_ingredients | std::views::join | std::ranges::to<IngredientEffects>();
-				// shuffle
-				std::ranges::shuffle(effects, a_rng);
-				// restore
-				a_ingredients = effects | std::views::chunk(4) | std::ranges::to<IngredientEffectGroups>();
-			};
-
-			constexpr auto is_distribution_unique = [](const IngredientEffectGroups& a_effectGroups) {
-				for (const auto& effectGroup : a_effectGroups) {
-					std::unordered_set<RE::EffectSetting*> set{};
-					for (const auto& effect : effectGroup) {
-						if (!set.emplace(effect->baseEffect).second) {
-							return false;
-						}
-					}
-				}
-				return true;
-			};
-
-			// initial shuffle, distribution probably contains duplicates
-			shuffle_effects(a_effectGroups, local_rng);
-
-			// divide into chunks
-			auto num_chunks = static_cast<std::size_t>(a_effectGroups.size() / std::thread::hardware_concurrency());
-			auto ingredient_chunks = a_effectGroups | std::views::chunk(num_chunks) | std::ranges::to<std::vector<IngredientEffectGroups>>();
-
-			// shuffle until unique
-			std::vector<std::future<void>> futures;
-			for (auto& chunk : ingredient_chunks) {
-				futures.emplace_back(std::async(std::launch::async, [&] {
-					RNG threadRNG(a_seed);
-					while (!is_distribution_unique(chunk)) {
-						shuffle_effects(chunk, threadRNG);
-					}
-				}));
-			}
+		ShuffleEffectGroups(a_seed, a_effectGroups.groups);
+		return;
+	}
 
-			for (auto& future : futures) {
-				future.wait();
-			}
+	// always permutes the original groups, the seed alone picks the layout
+	const auto                start = std::chrono::steady_clock::now();
+	Randomizer::ShuffleResult result;
+	auto                      keyed = Randomizer::make_keyed_shuffle(a_seed, effectTable, originalEffectGroups, threadPool.get(), result);
+	const auto                elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	stats.AddTime("ShuffleEffectGroups", elapsed);
+	stats.AddShuffle(a_seed, shuffleMethod, elapsed, result);
+
+	LogShuffleResult(result);
+
+	if (result.success()) {
+		a_effectGroups.keyed = std::move(keyed);
+		a_effectGroups.groups = {};
+		logger::info("\tStored {} repaired effect slots with the seed", result.patches);
+	} else {
+		a_effectGroups.keyed.reset();
+		a_effectGroups.groups.assign(originalEffectGroups.begin(), originalEffectGroups.end());
+		Randomizer::shuffle_effect_groups(a_seed, SHUFFLE_METHOD::kSwap, effectTable, a_effectGroups.groups);
+	}
+}
+
+void Manager::ShuffleEffectGroups(std::uint64_t a_seed, Randomizer::IngredientEffectGroups& a_effectGroups) const
+{
+	const auto start = std::chrono::steady_clock::now();
+	const auto result = Randomizer::shuffle_effect_groups(a_seed, shuffleMethod, effectTable, a_effectGroups, threadPool.get(), shuffleConstraints);
+	const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	stats.AddTime("ShuffleEffectGroups", elapsed);
+	stats.AddShuffle(a_seed, shuffleMethod, elapsed, result);
+
+	LogShuffleResult(result);
+
+	if (!result.success()) {
+		Randomizer::shuffle_effect_groups(a_seed, SHUFFLE_METHOD::kSwap, effectTable, a_effectGroups);
+	}
+}
 
-			// Rejoin shuffled chunks
-			a_effectGroups = std::views::join(ingredient_chunks) | std::ranges::to<IngredientEffectGroups>();
+bool Manager::ReadShuffleCache(ShuffledIngredientEffectGroups& a_effectGroups)
+{
+	if (shuffleCacheKey == 0) {
+		return false;
+	}
+
+	const auto timer = stats.Time("ReadShuffleCache");
+
+	auto effectGroups = Randomizer::read_shuffle_cache(shuffleCachePath, shuffleCacheKey, effectTable);
+	if (!effectGroups || effectGroups->size() != originalEffectGroups.size()) {
+		logger::info("\tNo cached shuffle for this load order, seed and method");
+		return false;
+	}
+
+	a_effectGroups.groups = std::move(*effectGroups);
+	a_effectGroups.keyed.reset();
+	stats.AddCount("ShuffleCacheHits");
+	logger::info("\tUsing cached shuffle (inputs unchanged)");
+	return true;
+}
+
+void Manager::WriteShuffleCache()
+{
+	if (shuffleCacheKey == 0 || !threadPool) {
+		return;
+	}
+
+	// the applied groups, already resolved for keyed shuffles. The snapshot stays valid while the write is queued
+	threadPool->Submit([this, effectGroups = liveEffectGroups.Load()]() {
+		if (!Randomizer::write_shuffle_cache(shuffleCachePath, shuffleCacheKey, *effectGroups)) {
+			logger::warn("Couldn't write shuffle cache to {}", shuffleCachePath);
 		}
-		break;
-	default:
-		break;
+	});
+}
+
+void Manager::LogShuffleResult(const Randomizer::ShuffleResult& a_result) const
+{
+	if (a_result.status == Randomizer::ShuffleResult::STATUS::kUnsatisfiable) {
+		if (a_result.boundSlots > a_result.groupCount * 4) {
+			logger::error("\tCouldn't meet effect constraints : {} effects on at least {} ingredients need {} effect slots, only {} exist. Swapping effect groups instead", a_result.baseCount, shuffleConstraints.minPerBase, a_result.boundSlots, a_result.groupCount * 4);
+		} else {
+			logger::error("\tCouldn't meet effect constraints : {} effects on at most {} ingredients fill {} of {} effect slots. Swapping effect groups instead", a_result.baseCount, shuffleConstraints.maxPerBase, a_result.boundSlots, a_result.groupCount * 4);
+		}
+	} else if (!a_result.success()) {
+		const auto baseEffect = RE::TESForm::LookupByID<RE::EffectSetting>(a_result.overflowBase);
+		logger::error("\tCouldn't shuffle without duplicate effects : {} [0x{:X}] fills {} effect slots across {} ingredients. Swapping effect groups instead", edid::get_editorID(baseEffect), a_result.overflowBase, a_result.overflowCount, a_result.groupCount);
+	} else if (a_result.constructed) {
+		logger::info("\tRepair limit reached after {} swaps, used constructive distribution", a_result.repairs);
+	}
+	if (a_result.rebalanced > 0) {
+		logger::info("\tMoved {} effect slots to meet effect constraints", a_result.rebalanced);
+	}
+}
+
+void Manager::QueueNextShuffle()
+{
+	if (shuffleOn != SHUFFLE_ON::kAlchemyMenu || reshuffleUsedIngredients || !threadPool || !shuffledEffectGroups.shuffled) {
+		return;
 	}
+
+	// shuffle a copy of the live groups while the player is away from the alchemy table, the game thread only swaps it in
+	nextShuffle = threadPool->Submit([this, seed = GetRNGSeed()]() {
+		ShuffledIngredientEffectGroups effectGroups;
+		if (shuffleMethod != SHUFFLE_METHOD::kPermutation) {
+			effectGroups.groups = *liveEffectGroups.Load();
+		}
+		ShuffleEffectGroups(seed, effectGroups);
+		return PendingShuffle{ std::move(effectGroups), seed };
+	});
 }
 
-void Manager::ShuffleIngredientEffects(ShuffledIngredientEffectGroups& a_effectGroups, bool a_reshuffle) const
+void Manager::ApplyNextShuffle()
 {
-	auto& [ingredientEffectGroup, shuffled] = a_effectGroups;
-	if (ingredientEffectGroup.empty()) {
-		ingredientEffectGroup.assign(originalEffectGroups.begin(), originalEffectGroups.end());
+	if (nextShuffle.valid()) {
+		auto [effectGroups, seed] = nextShuffle.get();
+		shuffledEffectGroups = std::move(effectGroups);
+		shuffledEffectGroups.shuffled = true;
+		ApplyEffectGroups(shuffledEffectGroups);
+		logger::info("\tShuffled {} ingredient effects ({} individual effects | RNG seed : {} | precomputed)", originalEffectGroups.size(), originalEffectGroups.size() * 4, seed);
+	} else {
+		ShuffleIngredientEffects(shuffledEffectGroups, true);
 	}
-	if (ingredientEffectGroup.empty()) {
+
+	QueueNextShuffle();
+}
+
+void Manager::ReshuffleUsedIngredients(std::vector<std::uint32_t> a_slots)
+{
+	if (a_slots.empty() || !shuffledEffectGroups.shuffled) {
 		return;
 	}
+
+	const auto timer = stats.Time("ReshuffleUsedIngredients");
+
+	// the partial reshuffle edits groups in place
+	auto& effectGroups = shuffledEffectGroups.groups;
+	if (auto& keyed = shuffledEffectGroups.keyed) {
+		keyed->Materialize(originalEffectGroups, effectGroups, threadPool.get());
+		keyed.reset();
+	}
+
+	std::ranges::sort(a_slots);
+	const auto [first, last] = std::ranges::unique(a_slots);
+	a_slots.erase(first, last);
+
 	const auto seed = GetRNGSeed();
-	if (!shuffled || a_reshuffle) {
-		shuffle_effect_groups(seed, ingredientEffectGroup);
+	const auto swaps = Randomizer::reshuffle_effect_groups(seed, effectTable, effectGroups, a_slots);
+
+	if (const auto dataHandler = RE::TESDataHandler::GetSingleton()) {
+		const auto& ingredients = dataHandler->GetFormArray<RE::IngredientItem>();
+		const auto  get_effect = [&](std::uint32_t a_effectSlot) -> RE::Effect*& { return ingredients[eligibleIngredients.GetPosition(a_effectSlot / 4)]->effects[a_effectSlot % 4]; };
+
+		// effect objects follow their effect, every object stays on exactly one ingredient
+		std::vector<std::uint32_t> changed;
+		changed.reserve(swaps.size() * 2);
+		for (const auto& [effectSlot, partnerSlot] : swaps) {
+			std::swap(get_effect(effectSlot), get_effect(partnerSlot));
+			appliedEffects.Swap(effectSlot, partnerSlot);
+			changed.push_back(effectSlot / 4);
+			changed.push_back(partnerSlot / 4);
+		}
+
+		std::ranges::sort(changed);
+		const auto [changedFirst, changedLast] = std::ranges::unique(changed);
+		changed.erase(changedFirst, changedLast);
+		UnlearnIngredientEffects(changed);
+		liveEffectGroups.Store(appliedEffects.GetEffectGroups());
+		UpdateEffectIndex(effectGroups, changed);
+
+		logger::info("\tReshuffled {} used ingredients ({} swaps, {} ingredients changed | RNG seed : {})", a_slots.size(), swaps.size(), changed.size(), seed);
+	}
+
+	stats.AddCount("ReshuffledIngredients", a_slots.size());
+}
+
+void Manager::LogStats() const
+{
+	logger::info("{:*^30}", "STATS");
+	for (const auto& line : stats.GetSummary()) {
+		logger::info("\t{}", line);
 	}
-	if (!shuffled || a_reshuffle || shuffleOn == SHUFFLE_ON::kPlaythrough) {
-		ApplyEffectGroups(ingredientEffectGroup);
-		logger::info("\tShuffled {} ingredient effects ({} individual effects | RNG seed : {})", ingredientEffectGroup.size(), ingredientEffectGroup.size() * 4, seed);
+}
+
+void Manager::WriteStats()
+{
+	if (statsPath.empty() || !threadPool) {
+		return;
 	}
-	shuffled = true;
+	threadPool->Submit([this]() {
+		stats.Write(statsPath);
+	});
 }
 
 std::uint64_t Manager::GetCurrentPlayerID()
@@ -303,6 +766,30 @@ bool Manager::ShouldShuffleOnLoadSaveOrNewGame(bool a_saveLoad)
 	}
 }
 
+void Manager::log_coalesced(spdlog::level::level_enum a_level, std::string_view a_what, const std::vector<std::string>& a_entries)
+{
+	if (a_entries.empty()) {
+		return;
+	}
+
+	// one line per batch, verbose logging lists every entry
+	constexpr std::size_t maxShown = 5;
+	const auto            shown = spdlog::should_log(spdlog::level::debug) ? a_entries.size() : std::min(a_entries.size(), maxShown);
+
+	std::string list;
+	for (std::size_t i = 0; i < shown; ++i) {
+		if (i != 0) {
+			list += ", ";
+		}
+		list += a_entries[i];
+	}
+	if (shown < a_entries.size()) {
+		list += std::format(", ... (+{})", a_entries.size() - shown);
+	}
+
+	spdlog::log(a_level, "{} {} : {}", a_entries.size(), a_what, list);
+}
+
 std::uint64_t Manager::get_game_playerID()
 {
 	return RE::BGSSaveLoadManager::GetSingleton()->currentPlayerID & 0xFFFFFFFF;
@@ -319,46 +806,59 @@ std::uint64_t Manager::save_to_playerID(const std::string& a_savePath)
 
 void Manager::OnLoad(const std::string& a_savePath)
 {
+	const auto timer = stats.Time("OnLoad");
+
 	currentSave = a_savePath;
 	GetPlayerIDFromSave();
 
-	if (const auto it = ingredientKnownEffectsSaveMap.find(currentSave); it != ingredientKnownEffectsSaveMap.end()) {
-		currentIngredientKnownEffectsMap = it->second;
-	} else {
-		currentIngredientKnownEffectsMap.clear();
-	}
+	knownEffects.Load(currentSave);
 
-	logger::info("Loaded : {} | {} ingredients known", a_savePath, currentIngredientKnownEffectsMap.size());
+	logger::info("Loaded : {} | {} ingredients known", a_savePath, knownEffects.GetCurrentSize());
 
 	if (ShouldShuffleOnLoadSaveOrNewGame(true)) {
 		ShuffleIngredientEffects(shuffleOn == SHUFFLE_ON::kPlaythrough ? playthroughEffectGroupMap[currentPlayerID] : shuffledEffectGroups);
 	}
 }
 
+void Manager::OnPostLoadGame()
+{
+	// ingredients read their known effects from the save after PreLoadGame, unlearn them all at once here
+	UnlearnAllIngredientEffects();
+
+	// the stats json is rewritten on save, only repeat the full summary here when asked for
+	if (logLevel == LOG_LEVEL::kVerbose) {
+		LogStats();
+	}
+}
+
 void Manager::OnSave(const std::string& a_savePath)
 {
+	const auto timer = stats.Time("OnSave");
+
 	currentSave = a_savePath;
 
 	if (const auto dataHandler = RE::TESDataHandler::GetSingleton()) {
-		for (const auto& ingredient : dataHandler->GetFormArray<RE::IngredientItem>()) {
-			if (ingredient && !blacklist.contains(ingredient)) {
-				if (ingredient->gamedata.knownEffectFlags != 0) {
-					currentIngredientKnownEffectsMap[edid::get_editorID(ingredient)] = ingredient->gamedata.knownEffectFlags;
-				}
+		const auto& ingredients = dataHandler->GetFormArray<RE::IngredientItem>();
+		for (std::uint32_t slot = 0; slot < eligibleIngredients.size(); ++slot) {
+			if (const auto ingredient = ingredients[eligibleIngredients.GetPosition(slot)]; ingredient->gamedata.knownEffectFlags != 0) {
+				knownEffects.Record(slot, ingredient->gamedata.knownEffectFlags);
 			}
 		}
 	}
 
-	logger::info("Save: {} | {} ingredients known", a_savePath, currentIngredientKnownEffectsMap.size());
+	logger::info("Save: {} | {} ingredients known", a_savePath, knownEffects.GetCurrentSize());
 
-	ingredientKnownEffectsSaveMap[currentSave] = currentIngredientKnownEffectsMap;
+	knownEffects.Save(currentSave);
 
-	[[maybe_unused]] auto ec = glz::write_file(ingredientKnownEffectsSaveMap, ingredientKnownEffectsPath, std::string());
+	if (logLevel == LOG_LEVEL::kVerbose) {
+		LogStats();
+	}
+	WriteStats();
 }
 
 void Manager::OnDeleteSave(const std::string& a_savePath)
 {
-	ingredientKnownEffectsSaveMap.erase(a_savePath);
+	knownEffects.Delete(a_savePath);
 }
 
 void Manager::OnNewGame()
@@ -392,13 +892,28 @@ RE::BSEventNotifyControl Manager::ProcessEvent(const RE::MenuOpenCloseEvent* a_e
 			}
 			if (isAlchemyMenu) {
 				RE::ItemCrafted::GetEventSource()->AddEventSink(GetSingleton());
+				if (reshuffleUsedIngredients) {
+					usedIngredients.clear();
+					RE::ScriptEventSourceHolder::GetSingleton()->AddEventSink<RE::TESContainerChangedEvent>(GetSingleton());
+				}
+			}
+		} else if (isAlchemyMenu) {
+			if (reshuffleUsedIngredients) {
+				RE::ScriptEventSourceHolder::GetSingleton()->RemoveEventSink<RE::TESContainerChangedEvent>(GetSingleton());
+			}
+			if (hasCraftedPotion) {
+				hasCraftedPotion = false;
+				if (reshuffleUsedIngredients) {
+					SKSE::GetTaskInterface()->AddTask([this, slots = std::exchange(usedIngredients, {})]() mutable {
+						ReshuffleUsedIngredients(std::move(slots));
+					});
+				} else {
+					SKSE::GetTaskInterface()->AddTask([this]() {
+						ApplyNextShuffle();
+					});
+				}
+				RE::ItemCrafted::GetEventSource()->RemoveEventSink(GetSingleton());
 			}
-		} else if (isAlchemyMenu && hasCraftedPotion) {
-			hasCraftedPotion = false;
-			SKSE::GetTaskInterface()->AddTask([this]() {
-				ShuffleIngredientEffects(shuffledEffectGroups, true);
-			});
-			RE::ItemCrafted::GetEventSource()->RemoveEventSink(GetSingleton());
 		}
 	}
 
@@ -417,3 +932,19 @@ RE::BSEventNotifyControl Manager::ProcessEvent(const RE::ItemCrafted::Event* a_e
 
 	return RE::BSEventNotifyControl::kContinue;
 }
+
+RE::BSEventNotifyControl Manager::ProcessEvent(const RE::TESContainerChangedEvent* a_event, RE::BSTEventSource<RE::TESContainerChangedEvent>*)
+{
+	// ingredients consumed by crafting leave the player's inventory without a destination
+	if (!a_event || !isAlchemyMenu || a_event->oldContainer != RE::PlayerCharacter::GetSingleton()->GetFormID() || a_event->newContainer != 0) {
+		return RE::BSEventNotifyControl::kContinue;
+	}
+
+	if (const auto ingredient = RE::TESForm::LookupByID<RE::IngredientItem>(a_event->baseObj)) {
+		if (const auto slot = GetIngredientSlot(ingredient)) {
+			usedIngredients.push_back(*slot);
+		}
+	}
+
+	return RE::BSEventNotifyControl::kContinue;
+}
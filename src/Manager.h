@@ -1,27 +1,26 @@
 #pragma once
 
-using IngredientEffects = std::vector<RE::Effect*>;
-using IngredientEffectGroups = std::vector<IngredientEffects>;
-
-using IngredientKnownEffectsMap = std::unordered_map<std::string, std::uint16_t>;  // IngredientEDID -> KnownEffectFlags
-
 struct ShuffledIngredientEffectGroups
 {
-	IngredientEffectGroups groups{};
-	bool                   shuffled{ false };
+	Randomizer::IngredientEffectGroups      groups{};
+	std::optional<Randomizer::KeyedShuffle> keyed{};  // kPermutation : groups stay empty, resolved against the original groups when applied
+	bool                                    shuffled{ false };
+};
+
+struct PendingShuffle
+{
+	ShuffledIngredientEffectGroups effectGroups{};
+	std::uint64_t                  seed{ 0 };
 };
 
 class Manager :
 	public ISingleton<Manager>,
 	public RE::BSTEventSink<RE::MenuOpenCloseEvent>,
-	public RE::BSTEventSink<RE::ItemCrafted::Event>
+	public RE::BSTEventSink<RE::ItemCrafted::Event>,
+	public RE::BSTEventSink<RE::TESContainerChangedEvent>
 {
 public:
-	enum class SHUFFLE_METHOD
-	{
-		kSwap,
-		kShuffle
-	};
+	using SHUFFLE_METHOD = Randomizer::SHUFFLE_METHOD;
 
 	enum class SHUFFLE_ON
 	{
@@ -30,64 +29,137 @@ public:
 		kAlchemyMenu
 	};
 
+	enum class LOG_LEVEL
+	{
+		kWarning,
+		kSummary,
+		kVerbose
+	};
+
 	void OnPostLoad();
 	void OnDataLoad();
 
 	void OnLoad(const std::string& a_savePath);
+	void OnPostLoadGame();
 	void OnSave(const std::string& a_savePath);
 	void OnDeleteSave(const std::string& a_savePath);
 	void OnNewGame();
 
-	void ShuffleIngredientEffects(ShuffledIngredientEffectGroups& a_effectGroups, bool a_reshuffle = false) const;
-	void UnlearnIngredientEffects(RE::IngredientItem* a_ingredient) const;
+	void ShuffleIngredientEffects(ShuffledIngredientEffectGroups& a_effectGroups, bool a_reshuffle = false);
+	void OnEffectIndexRequest(const char* a_sender);
 
 private:
 	void LoadSettings();
 	void LoadBlacklist();
 	void InitBlacklist();
 	void LoadIngredientEffects();
+	void ExportIngredients(std::vector<Randomizer::IngredientKey> a_keys, std::vector<std::string> a_editorIDs) const;
+	void BuildEffectIndex();
+	void UpdateEffectIndex(const Randomizer::IngredientEffectGroups& a_effectGroups, std::span<const std::uint32_t> a_slots);
+	void PublishEffectIndex(const char* a_receiver = nullptr);
+
+	[[nodiscard]] bool KeepKnownEffects() const;
+	void               BuildKeepMasks();
+	void               UnlearnIngredientEffects(std::span<const std::uint32_t> a_slots);
+	void               UnlearnAllIngredientEffects();
+
+	std::optional<std::uint32_t> GetIngredientSlot(const RE::IngredientItem* a_ingredient) const;
 
 	std::uint64_t GetCurrentPlayerID();
 	void          GetPlayerIDFromSave();
 	bool          ShouldShuffleOnLoadSaveOrNewGame(bool a_saveLoad);
 
 	std::uint64_t GetRNGSeed(bool a_onDataLoad = false) const;
-	void          ApplyEffectGroups(const IngredientEffectGroups& a_effectGroups) const;
-
+	void          ShuffleEffectGroups(std::uint64_t a_seed, Randomizer::IngredientEffectGroups& a_effectGroups) const;
+	void          ShuffleEffectGroups(std::uint64_t a_seed, ShuffledIngredientEffectGroups& a_effectGroups) const;
+	void          LogShuffleResult(const Randomizer::ShuffleResult& a_result) const;
+	bool          ReadShuffleCache(ShuffledIngredientEffectGroups& a_effectGroups);
+	void          WriteShuffleCache();
+	void          AddEffectInstances(const Randomizer::IngredientEffectGroups& a_effectGroups);
+	void          ApplyEffectGroups(const Randomizer::IngredientEffectGroups& a_effectGroups);
+	void          ApplyEffectGroups(const ShuffledIngredientEffectGroups& a_effectGroups);
+
+	void QueueNextShuffle();
+	void ApplyNextShuffle();
+	void ReshuffleUsedIngredients(std::vector<std::uint32_t> a_slots);
+
+	void LogStats() const;
+	void WriteStats();
+
+	static void          log_coalesced(spdlog::level::level_enum a_level, std::string_view a_what, const std::vector<std::string>& a_entries);
 	static std::uint64_t get_game_playerID();
 	static std::uint64_t save_to_playerID(const std::string& a_savePath);
-	void                 shuffle_effect_groups(std::uint64_t a_seed, IngredientEffectGroups& a_effectGroups) const;
-	[[nodiscard]] bool   can_unlearn_effect(const std::optional<std::uint16_t>& a_effectKnownFlag, std::uint32_t a_effectIdx) const;
 
 	RE::BSEventNotifyControl ProcessEvent(const RE::MenuOpenCloseEvent* a_event, RE::BSTEventSource<RE::MenuOpenCloseEvent>*) override;
 	RE::BSEventNotifyControl ProcessEvent(const RE::ItemCrafted::Event* a_event, RE::BSTEventSource<RE::ItemCrafted::Event>*) override;
+	RE::BSEventNotifyControl ProcessEvent(const RE::TESContainerChangedEvent* a_event, RE::BSTEventSource<RE::TESContainerChangedEvent>*) override;
 
 	// members
 	std::string folder{ "AlchemyEffectRandomizer" };
-	std::string ingredientKnownEffectsPath{ R"(Data\AlchemyEffectRandomizer\IngredientKnownEffects.json)" };
+	std::string ingredientKnownEffectsPath{ R"(Data\AlchemyEffectRandomizer\IngredientKnownEffects.json)" };  // legacy, migrated once
+	std::string knownEffectsFolder{ R"(Data\AlchemyEffectRandomizer\KnownEffects)" };
+
+	std::string                             blacklistCachePath{ R"(Data\AlchemyEffectRandomizer\Cache\Blacklist.bin)" };
+	Randomizer::BlacklistRules              blacklistRules;  // EDIDs, EDID prefixes and plugins from every ini
+	std::unordered_set<RE::IngredientItem*> blacklist;       // IngredientItem, only consulted while building the eligibility index
+
+	SHUFFLE_METHOD                 shuffleMethod{ SHUFFLE_METHOD::kShuffle };
+	Randomizer::ShuffleConstraints shuffleConstraints;
+	SHUFFLE_ON                     shuffleOn{ SHUFFLE_ON::kPlaythrough };
+
+	Randomizer::EligibilityIndex                                     eligibleIngredients;  // effect group slot -> form array position
+	std::vector<std::pair<const RE::IngredientItem*, std::uint32_t>> ingredientSlots;      // sorted by address, ingredient -> slot
+
+	Randomizer::EffectTable            effectTable;
+	Randomizer::EffectInstances        effectInstances;
+	std::vector<RE::Effect*>           effects;  // Randomizer::InstanceID -> Effect
+	Randomizer::AppliedEffects         appliedEffects;  // what each ingredient currently holds, applies only write the difference
+	Randomizer::IngredientEffectGroups originalEffectGroups;
+	ShuffledIngredientEffectGroups     shuffledEffectGroups;  // gameload/static, game thread only
 
-	std::unordered_set<std::string>         blacklistIDs;  // EDID
-	std::unordered_set<RE::IngredientItem*> blacklist;     // IngredientItem
+	// copy of appliedEffects' groups, republished after every change. Read from any thread without locking
+	Randomizer::Published<Randomizer::IngredientEffectGroups> liveEffectGroups;
 
-	SHUFFLE_METHOD shuffleMethod{ SHUFFLE_METHOD::kShuffle };
-	SHUFFLE_ON     shuffleOn{ SHUFFLE_ON::kPlaythrough };
+	// effect -> ingredients, for other plugins (see AlchemyEffectRandomizerAPI.h)
+	Randomizer::ReverseIndex                  reverseIndex;
+	std::vector<std::uint32_t>                effectFormIDs;    // BaseIndex -> EffectSetting FormID
+	std::vector<std::uint32_t>                sortedEffects;    // BaseIndex, ordered by FormID
+	std::vector<RE::IngredientItem*>          ingredientForms;  // slot -> ingredient
+	AlchemyEffectRandomizer::API::EffectIndex effectIndex{};    // points into the above, sent with every change
 
-	IngredientEffectGroups         originalEffectGroups;
-	ShuffledIngredientEffectGroups shuffledEffectGroups;  // gameload/static
+	std::string   shuffleCachePath{ R"(Data\AlchemyEffectRandomizer\Cache\Shuffle.bin)" };
+	std::uint64_t shuffleCacheKey{ 0 };  // 0 : seed isn't fixed, nothing is cached
 
 	bool          newGameStarted{ false };
 	std::string   currentSave{};
 	std::uint64_t currentPlayerID{ std::numeric_limits<std::uint64_t>::max() };
 	std::uint64_t oldPlayerID{ std::numeric_limits<std::uint64_t>::max() };
 
-	std::unordered_map<std::uint64_t, ShuffledIngredientEffectGroups> playthroughEffectGroupMap;  // playerID -> IngredientEffectGroups
+	// playerID -> IngredientEffectGroups, game thread only. Seeded by playerID, so evicted playthroughs are regenerated identically
+	std::uint32_t                                                       playthroughCacheSize{ 4 };
+	Randomizer::LRUCache<std::uint64_t, ShuffledIngredientEffectGroups> playthroughEffectGroupMap;
 
-	bool isAlchemyMenu{ false };
-	bool hasCraftedPotion{ false };
+	bool                        isAlchemyMenu{ false };
+	bool                        hasCraftedPotion{ false };
+	std::future<PendingShuffle> nextShuffle;  // alchemy menu, computed in the background after each apply
 
-	bool                                                       unlearnIngredients{ false };
-	std::unordered_map<std::string, IngredientKnownEffectsMap> ingredientKnownEffectsSaveMap;
-	IngredientKnownEffectsMap                                  currentIngredientKnownEffectsMap;
+	bool                       reshuffleUsedIngredients{ false };
+	std::vector<std::uint32_t> usedIngredients;  // slots consumed during the current alchemy session
+
+	bool                       unlearnIngredients{ false };
+	Randomizer::KnownEffects   knownEffects;
+	std::vector<std::uint16_t> keepMasks;  // slot -> known effects that stay learned, rebuilt for each unlearn pass
 
 	std::uint64_t fixedSeed{ 0 };
+
+	LOG_LEVEL logLevel{ LOG_LEVEL::kSummary };
+
+	mutable Randomizer::Stats stats;  // written next to the SKSE log
+	std::filesystem::path     statsPath;
+
+	bool                  exportIngredients{ false };
+	std::filesystem::path ingredientDumpPath;  // next to the SKSE log, read by RandomizerBatch
+
+	std::uint32_t                           workerThreads{ 0 };
+	std::unique_ptr<Randomizer::ThreadPool> threadPool;  // declared last, joins its workers before the members their tasks use go away
 };
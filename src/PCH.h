@@ -14,10 +14,28 @@
 #include "ClibUtil/singleton.hpp"
 #include "ClibUtil/timer.hpp"
 #include <glaze/glaze.hpp>
+#include <spdlog/async.h>
 #include <spdlog/sinks/basic_file_sink.h>
 
 #include "ClibUtil/editorID.hpp"
 
+#include "Randomizer/Apply.h"
+#include "Randomizer/Blacklist.h"
+#include "Randomizer/EffectTable.h"
+#include "Randomizer/Eligibility.h"
+#include "Randomizer/IngredientDump.h"
+#include "Randomizer/KnownEffects.h"
+#include "Randomizer/LRUCache.h"
+#include "Randomizer/Permutation.h"
+#include "Randomizer/ReverseIndex.h"
+#include "Randomizer/Shuffle.h"
+#include "Randomizer/ShuffleCache.h"
+#include "Randomizer/Snapshot.h"
+#include "Randomizer/Stats.h"
+#include "Randomizer/ThreadPool.h"
+
+#include "AlchemyEffectRandomizerAPI.h"
+
 #define DLLEXPORT __declspec(dllexport)
 
 namespace logger = SKSE::log;
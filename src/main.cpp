@@ -23,6 +23,11 @@ void OnInit(SKSE::MessagingInterface::Message* a_msg)
 			Manager::GetSingleton()->OnLoad(savePath);
 		}
 		break;
+	case SKSE::MessagingInterface::kPostLoadGame:
+		if (static_cast<bool>(a_msg->data)) {
+			Manager::GetSingleton()->OnPostLoadGame();
+		}
+		break;
 	case SKSE::MessagingInterface::kDeleteGame:
 		{
 			const std::string savePath({ static_cast<char*>(a_msg->data), a_msg->dataLen });
@@ -37,6 +42,13 @@ void OnInit(SKSE::MessagingInterface::Message* a_msg)
 	}
 }
 
+void OnAPIMessage(SKSE::MessagingInterface::Message* a_msg)
+{
+	if (a_msg->type == AlchemyEffectRandomizer::API::kRequestEffectIndex) {
+		Manager::GetSingleton()->OnEffectIndexRequest(a_msg->sender);
+	}
+}
+
 #ifdef SKYRIM_AE
 extern "C" DLLEXPORT constinit auto SKSEPlugin_Version = []() {
 	SKSE::PluginVersionData v;
@@ -71,6 +83,8 @@ extern "C" DLLEXPORT bool SKSEAPI SKSEPlugin_Query(const SKSE::QueryInterface* a
 }
 #endif
 
+constexpr std::size_t logQueueSize = 8192;
+
 void InitializeLog()
 {
 	auto path = logger::log_directory();
@@ -81,10 +95,14 @@ void InitializeLog()
 	*path /= fmt::format(FMT_STRING("{}.log"), Version::PROJECT);
 	auto sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(path->string(), true);
 
-	auto log = std::make_shared<spdlog::logger>("global log"s, std::move(sink));
+	// lines go to a bounded queue written by a background thread, the game thread never waits on the file:
+	// when the queue is full the oldest lines are dropped instead of blocking
+	spdlog::init_thread_pool(logQueueSize, 1);
+	auto log = std::make_shared<spdlog::async_logger>("global log"s, std::move(sink), spdlog::thread_pool(), spdlog::async_overflow_policy::overrun_oldest);
 
 	log->set_level(spdlog::level::info);
-	log->flush_on(spdlog::level::info);
+	log->flush_on(spdlog::level::warn);
+	spdlog::flush_every(std::chrono::seconds(1));
 
 	spdlog::set_default_logger(std::move(log));
 	spdlog::set_pattern("%v"s);
@@ -102,6 +120,7 @@ extern "C" DLLEXPORT bool SKSEAPI SKSEPlugin_Load(const SKSE::LoadInterface* a_s
 
 	auto messaging = SKSE::GetMessagingInterface();
 	messaging->RegisterListener("SKSE", OnInit);
+	messaging->RegisterListener(nullptr, OnAPIMessage);  // requests from any plugin, see AlchemyEffectRandomizerAPI.h
 
 	return true;
 }